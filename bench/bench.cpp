@@ -0,0 +1,418 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// Headless throughput benchmark. CPU test programs run on a flat RAM bus and a
+// BASIC boot runs on the full machine, each for a fixed number of cycles. ULA
+// painting is timed for the frames of the same number of cycles, and AY sound
+// generation for the samples of them. One CSV line
+// per benchmark is printed to stdout, emulator messages go to stderr.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "oric.hpp"
+#include "config.hpp"
+#include "chip/mos6502_bus.hpp"
+
+namespace po = boost::program_options;
+
+
+struct Result
+{
+    std::string name;
+    uint64_t cycles;
+    uint64_t instructions;
+    double seconds;
+    std::string status;
+};
+
+typedef std::function<std::string(Memory& memory, uint16_t trap_address)> f_check_result;
+
+
+/**
+ * Read whole file.
+ * @param path path of file
+ * @param data vector to read file into
+ * @return false if file could not be read
+ */
+static bool read_file(const std::string& path, std::vector<uint8_t>& data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (! file) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * Run CPU test program on flat RAM for given number of cycles. The program is
+ * reloaded and restarted each time it ends in a jump to itself.
+ * @param name benchmark name
+ * @param image program image
+ * @param load_address address to load image at
+ * @param start_address address to start execution at
+ * @param budget number of cycles to run
+ * @param check function giving status from memory when program has ended
+ * @return benchmark result
+ */
+static Result run_test_program(const std::string& name, const std::vector<uint8_t>& image, uint16_t load_address,
+                               uint16_t start_address, uint64_t budget, f_check_result check)
+{
+    Result result{name, 0, 0, 0.0, "no-trap"};
+
+    Memory memory(65536);
+    MOS6502<FlatBus> cpu{FlatBus(memory)};
+
+    auto load = [&]() {
+        std::copy(image.begin(), image.end(), memory.mem + load_address);
+        cpu.set_pc(start_address);
+    };
+    load();
+
+    bool brk = false;
+    auto start = std::chrono::steady_clock::now();
+
+    while (result.cycles < budget) {
+        uint16_t pc = cpu.get_pc();
+        result.cycles += cpu.exec_instruction(brk);
+
+        if (cpu.get_pc() == pc || brk) {
+            result.status = brk ? "brk" : check(memory, pc);
+            brk = false;
+            load();
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.instructions = cpu.instruction_count;
+    return result;
+}
+
+/**
+ * Boot BASIC ROM on the full machine without frontend and let it run for given number of cycles.
+ * @param rom_path path to BASIC ROM
+ * @param budget number of cycles to run
+ * @param cycle_exact true to step all chips every cycle
+ * @param hle true to run known ROM routines natively
+ * @return benchmark result
+ */
+static Result run_basic_boot(const std::string& rom_path, uint64_t budget, bool cycle_exact, bool hle)
+{
+    Result result{"basic_boot", 0, 0, 0.0, "ok"};
+
+    std::vector<const char*> args = {"bench_run"};
+    if (cycle_exact) {
+        args.push_back("--cycle-exact");
+    }
+    Config config;
+    config.parse(args.size(), const_cast<char**>(args.data()));
+
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init(nullptr);
+    machine.memory.load(rom_path, 0xc000);
+    machine.reset();
+    if (hle) {
+        machine.enable_hle();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (! machine.run_for(budget, &oric)) {
+        result.status = "break";
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cycles = machine.get_cycle();
+    result.instructions = machine.cpu->instruction_count;
+    return result;
+}
+
+/**
+ * Paint full frames of a busy text screen, with every line changed each frame.
+ * @param name benchmark name
+ * @param frames number of frames to paint
+ * @param vector true to paint character cells in one 64 bit word
+ * @return benchmark result, status is frames per second
+ */
+static Result run_ula(const std::string& name, uint64_t frames, bool vector)
+{
+    Result result{name, 0, 0, 0.0, "ok"};
+
+    Config config;
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init(nullptr);
+
+    for (uint32_t i = 0xb400; i < 0xc000; ++i) {
+        machine.memory.mem[i] = i * 37 + (i >> 8);
+    }
+    for (uint32_t i = 0xbb80; i < 0xc000; i += 40) {
+        machine.memory.mem[i] = 0x10 + (i & 7);     // Paper color per row.
+    }
+
+    ULA ula(&machine, &machine.memory, Frontend::texture_width, Frontend::texture_height, Frontend::texture_bpp);
+    ula.set_vector_paint(vector);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        ula.invalidate();
+        while (! ula.paint_raster()) {
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cycles = frames * 312 * 64;
+
+    char status[32];
+    snprintf(status, sizeof(status), "fps:%.0f", result.seconds > 0 ? frames / result.seconds : 0);
+    result.status = status;
+    return result;
+}
+
+/**
+ * Paint frames of a text screen while glyphs are redefined on every raster
+ * line, as smooth scrolling and animation of redefined characters do.
+ * @param name benchmark name
+ * @param frames number of frames to paint
+ * @return benchmark result, status is frames per second
+ */
+static Result run_ula_charset(const std::string& name, uint64_t frames)
+{
+    Result result{name, 0, 0, 0.0, "ok"};
+
+    Config config;
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init(nullptr);
+
+    for (uint32_t i = 0xb400; i < 0xbb80; ++i) {
+        machine.memory.mem[i] = i * 37 + (i >> 8);
+    }
+    for (uint32_t i = 0xbb80; i < 0xc000; ++i) {
+        machine.memory.mem[i] = 'A' + i % 26;
+    }
+
+    ULA ula(&machine, &machine.memory, Frontend::texture_width, Frontend::texture_height, Frontend::texture_bpp);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        for (uint16_t raster = 0; raster < 312; ++raster) {
+            // Rotate one glyph row.
+            uint16_t address = 0xb400 + ('A' + raster % 26) * 8 + (raster / 26) % 8;
+            uint8_t row = machine.memory.mem[address];
+            machine.memory.mem[address] = ((row >> 1) | (row << 5)) & 0x3f;
+            ula.mark_written(address);
+            ula.paint_raster();
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cycles = frames * 312 * 64;
+
+    char status[32];
+    snprintf(status, sizeof(status), "fps:%.0f", result.seconds > 0 ? frames / result.seconds : 0);
+    result.status = status;
+    return result;
+}
+
+/**
+ * Run AY-3-8912 sound generation for given number of cycles, one step per
+ * 44.1 kHz sample as the audio callback does. All channels play tones with
+ * noise on an envelope.
+ * @param name benchmark name
+ * @param budget number of cycles to run
+ * @param band_limited true for band-limited synthesis
+ * @return benchmark result
+ */
+static Result run_ay(const std::string& name, uint64_t budget, bool band_limited)
+{
+    Result result{name, 0, 0, 0.0, "ok"};
+
+    AY3_8912::SoundState state;
+    state.reset();
+    state.band_limited = band_limited;
+    const uint8_t registers[][2] = {
+        {AY3_8912::CH_A_PERIOD_LOW, 0x77}, {AY3_8912::CH_B_PERIOD_LOW, 0x3b}, {AY3_8912::CH_C_PERIOD_LOW, 0x1d},
+        {AY3_8912::NOICE_PERIOD, 0x07}, {AY3_8912::ENABLE, 0x00}, {AY3_8912::CH_A_AMPLITUDE, 0x10},
+        {AY3_8912::CH_B_AMPLITUDE, 0x0c}, {AY3_8912::CH_C_AMPLITUDE, 0x10}, {AY3_8912::ENV_DURATION_LOW, 0x20},
+        {AY3_8912::ENV_SHAPE, 0x0e}
+    };
+    for (const uint8_t* reg : registers) {
+        RegisterChange change{0, reg[0], reg[1]};
+        state.exec_register_change(change);
+    }
+
+    uint64_t samples = budget * 44100 / 998400;
+    uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t sample = 0; sample < samples; ++sample) {
+        state.exec_audio(sample * 998400 / 44100);
+        sum += state.audio_out;
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cycles = state.last_cycle;
+
+    char status[32];
+    snprintf(status, sizeof(status), "sum:%08x", sum);
+    result.status = status;
+    return result;
+}
+
+/**
+ * Print result as CSV line.
+ * @param result benchmark result
+ */
+static void print_result(const Result& result)
+{
+    double mhz = result.seconds > 0 ? result.cycles / result.seconds / 1e6 : 0;
+    double ips = result.seconds > 0 ? result.instructions / result.seconds : 0;
+    double ns = result.instructions > 0 ? result.seconds * 1e9 / result.instructions : 0;
+
+    printf("%s,%llu,%llu,%.4f,%.2f,%.0f,%.2f,%s\n", result.name.c_str(),
+           (unsigned long long)result.cycles, (unsigned long long)result.instructions,
+           result.seconds, mhz, ips, ns, result.status.c_str());
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint64_t cycles;
+    std::string rom_dir;
+    bool cycle_exact = false;
+    bool hle = false;
+
+    try {
+        po::options_description desc("Allowed options");
+
+        desc.add_options()
+            ("help,?", "produce help message")
+            ("cycles,n", po::value<uint64_t>(&cycles)->default_value(50000000), "cycles to run per benchmark")
+            ("roms,r", po::value<std::string>(&rom_dir)->default_value("ROMS"), "directory with ROM files")
+            ("cycle-exact,c", po::bool_switch(&cycle_exact), "step all chips every clock cycle in BASIC boot")
+            ("hle", po::bool_switch(&hle), "run known ROM routines natively in BASIC boot");
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage: bench_run [options]" << std::endl << desc;
+            return 0;
+        }
+
+        po::notify(vm);
+    }
+    catch(std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    // Keep stdout for results only.
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    printf("benchmark,cycles,instructions,seconds,mhz,ips,ns_per_instruction,status\n");
+
+    std::vector<uint8_t> image;
+
+    // Klaus Dormann's functional test, full 64 KB image starting at $0400.
+    if (read_file(rom_dir + "/6502_functional_test.bin", image) && image.size() == 0x10000) {
+        print_result(run_test_program("functional_test", image, 0x0000, 0x0400, cycles,
+            [](Memory&, uint16_t trap_address) {
+                char status[16];
+                snprintf(status, sizeof(status), "trap:%04x", trap_address);
+                return std::string(status);
+            }));
+    }
+    else {
+        std::cerr << "Skipping functional_test: " << rom_dir << "/6502_functional_test.bin is not a 64 KB binary." << std::endl;
+        print_result({"functional_test", 0, 0, 0.0, "skipped"});
+    }
+
+    // AllSuiteA, $0210 is $ff when all tests pass or number of failed test.
+    if (read_file(rom_dir + "/AllSuiteA.rom", image) && image.size() <= 0xc000) {
+        print_result(run_test_program("allsuitea", image, 0x4000, 0x4000, cycles,
+            [](Memory& memory, uint16_t) {
+                if (memory.mem[0x0210] == 0xff) {
+                    return std::string("pass");
+                }
+                char status[16];
+                snprintf(status, sizeof(status), "fail:%02x", memory.mem[0x0210]);
+                return std::string(status);
+            }));
+    }
+    else {
+        std::cerr << "Skipping allsuitea: could not read " << rom_dir << "/AllSuiteA.rom." << std::endl;
+        print_result({"allsuitea", 0, 0, 0.0, "skipped"});
+    }
+
+    // Decimal mode ADC and SBC over zero page data, as in BCD score routines.
+    image.assign(0x300, 0);
+    for (uint32_t i = 0; i < 0x100; ++i) {
+        image[i] = i * 37;
+    }
+    const uint8_t decimal_loop[] = {
+        0xf8,               // SED
+        0xa2, 0x00,         // LDX #$00
+        0x18,               // CLC
+        0xa5, 0x10,         // LDA $10
+        0x75, 0x20,         // ADC $20,X
+        0x85, 0x10,         // STA $10
+        0x38,               // SEC
+        0xa5, 0x11,         // LDA $11
+        0xf5, 0x20,         // SBC $20,X
+        0x85, 0x11,         // STA $11
+        0xe8,               // INX
+        0xd0, 0xef,         // BNE $0203
+        0x4c, 0x14, 0x02    // JMP $0214
+    };
+    std::copy(std::begin(decimal_loop), std::end(decimal_loop), image.begin() + 0x200);
+    print_result(run_test_program("decimal", image, 0x0000, 0x0200, cycles,
+        [](Memory&, uint16_t trap_address) {
+            return std::string(trap_address == 0x0214 ? "ok" : "bad-trap");
+        }));
+
+    print_result(run_basic_boot(rom_dir + "/basic11b.rom", cycles, cycle_exact, hle));
+
+    // ULA painting with plain selects and with whole cells in one 64 bit word.
+    uint64_t frames = cycles / (312 * 64);
+    print_result(run_ula("ula_scalar", frames, false));
+    print_result(run_ula("ula_vector", frames, true));
+    print_result(run_ula_charset("ula_charset", frames));
+
+    // Sound point sampled and band-limited.
+    print_result(run_ay("ay", cycles, false));
+    print_result(run_ay("ay_band_limited", cycles, true));
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+#include "breakpoints.hpp"
+
+
+static const char* source_names[] = {"a", "x", "y", "p", "@"};
+static const char* compare_names[] = {"==", "!=", "<", ">"};
+
+
+bool Breakpoints::Condition::test(uint8_t source_value) const
+{
+    switch (compare) {
+        case COMPARE_EQ: return source_value == value;
+        case COMPARE_NE: return source_value != value;
+        case COMPARE_LT: return source_value < value;
+        case COMPARE_GT: return source_value > value;
+    }
+    return false;
+}
+
+
+Breakpoints::Breakpoints(Memory& memory) :
+    watch_hit(false),
+    watch_address(0),
+    watch_value(0),
+    watch_write(false),
+    memory(memory),
+    exec_count(0),
+    watch_count(0)
+{
+    std::fill(std::begin(exec_bits), std::end(exec_bits), 0);
+    std::fill(std::begin(read_bits), std::end(read_bits), 0);
+    std::fill(std::begin(write_bits), std::end(write_bits), 0);
+}
+
+bool Breakpoints::assign_bit(uint64_t* bits, uint16_t address, bool value)
+{
+    bool old = test_bit(bits, address);
+    if (value) {
+        bits[address >> 6] |= uint64_t(1) << (address & 63);
+    }
+    else {
+        bits[address >> 6] &= ~(uint64_t(1) << (address & 63));
+    }
+    return old;
+}
+
+void Breakpoints::set(uint16_t address)
+{
+    if (! assign_bit(exec_bits, address, true)) {
+        ++exec_count;
+    }
+    conditions.erase(address);
+}
+
+void Breakpoints::set(uint16_t address, const Condition& condition)
+{
+    set(address);
+    conditions[address] = condition;
+}
+
+bool Breakpoints::clear(uint16_t address)
+{
+    conditions.erase(address);
+    if (! assign_bit(exec_bits, address, false)) {
+        return false;
+    }
+    --exec_count;
+    return true;
+}
+
+void Breakpoints::set_watch(uint16_t address, bool read, bool write)
+{
+    bool was_watched = is_read_watched(address) || is_write_watched(address);
+
+    assign_bit(read_bits, address, read);
+    assign_bit(write_bits, address, write);
+
+    if (! was_watched && (read || write)) {
+        ++watch_count;
+    }
+    else if (was_watched && ! (read || write)) {
+        --watch_count;
+    }
+    update_page(address >> 8);
+}
+
+bool Breakpoints::clear_watch(uint16_t address)
+{
+    if (! is_read_watched(address) && ! is_write_watched(address)) {
+        return false;
+    }
+    set_watch(address, false, false);
+    return true;
+}
+
+const Breakpoints::Condition* Breakpoints::get_condition(uint16_t address) const
+{
+    auto it = conditions.find(address);
+    return it == conditions.end() ? nullptr : &it->second;
+}
+
+void Breakpoints::trigger_watch(uint16_t address, uint8_t value, bool write)
+{
+    watch_hit = true;
+    watch_address = address;
+    watch_value = value;
+    watch_write = write;
+}
+
+void Breakpoints::update_page(uint8_t page)
+{
+    bool read = false;
+    bool write = false;
+
+    for (uint32_t i = page * 4u; i < page * 4u + 4; ++i) {
+        read |= read_bits[i] != 0;
+        write |= write_bits[i] != 0;
+    }
+    memory.watch_page(page, read, write);
+}
+
+void Breakpoints::print()
+{
+    std::cout << std::hex << std::setfill('0');
+
+    for (uint32_t address = 0; address < 0x10000; ++address) {
+        if (is_set(address)) {
+            std::cout << "Breakpoint at $" << std::setw(4) << address;
+            if (const Condition* condition = get_condition(address)) {
+                std::cout << " if " << source_names[condition->source];
+                if (condition->source == SOURCE_MEMORY) {
+                    std::cout << std::setw(4) << condition->address;
+                }
+                std::cout << " " << compare_names[condition->compare] << " $"
+                          << std::setw(2) << (int)condition->value;
+            }
+            std::cout << std::endl;
+        }
+        if (is_read_watched(address) || is_write_watched(address)) {
+            std::cout << "Watchpoint at $" << std::setw(4) << address << " ("
+                      << (is_read_watched(address) ? "r" : "") << (is_write_watched(address) ? "w" : "")
+                      << ")" << std::endl;
+        }
+    }
+
+    if (empty()) {
+        std::cout << "No breakpoints or watchpoints." << std::endl;
+    }
+    std::cout << std::setfill(' ');
+}
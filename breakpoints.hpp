@@ -0,0 +1,171 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#ifndef BREAKPOINTS_H
+#define BREAKPOINTS_H
+
+#include <cstdint>
+#include <map>
+
+#include "memory.hpp"
+
+
+/**
+ * Execute breakpoints and memory watchpoints, kept as one bit per address.
+ *
+ * Pages with watched addresses are redirected to the I/O path in the memory
+ * page tables, so accesses to other pages are not slowed down. Stack accesses
+ * do not go through the page tables and are never watched.
+ */
+class Breakpoints
+{
+public:
+    enum Source
+    {
+        SOURCE_A,
+        SOURCE_X,
+        SOURCE_Y,
+        SOURCE_P,
+        SOURCE_MEMORY
+    };
+
+    enum Compare
+    {
+        COMPARE_EQ,
+        COMPARE_NE,
+        COMPARE_LT,
+        COMPARE_GT
+    };
+
+    /**
+     * Condition for a breakpoint, a register or memory value compared to a constant.
+     */
+    struct Condition
+    {
+        Source source;
+        uint16_t address;   // Address for SOURCE_MEMORY.
+        Compare compare;
+        uint8_t value;
+
+        /**
+         * Check condition against given value of the source.
+         * @param source_value current value of register or memory
+         * @return true if condition is met
+         */
+        bool test(uint8_t source_value) const;
+    };
+
+    Breakpoints(Memory& memory);
+
+    /**
+     * Set unconditional breakpoint, replacing any condition at address.
+     * @param address address to break at
+     */
+    void set(uint16_t address);
+
+    /**
+     * Set conditional breakpoint, replacing any condition at address.
+     * @param address address to break at
+     * @param condition condition that must be met to break
+     */
+    void set(uint16_t address, const Condition& condition);
+
+    /**
+     * Remove breakpoint.
+     * @param address address of breakpoint
+     * @return false if there was no breakpoint at address
+     */
+    bool clear(uint16_t address);
+
+    /**
+     * Watch reads and/or writes of address.
+     * @param address address to watch
+     * @param read true to break on reads
+     * @param write true to break on writes
+     */
+    void set_watch(uint16_t address, bool read, bool write);
+
+    /**
+     * Stop watching address.
+     * @param address watched address
+     * @return false if address was not watched
+     */
+    bool clear_watch(uint16_t address);
+
+    /**
+     * Print all breakpoints and watchpoints.
+     */
+    void print();
+
+    /**
+     * Check if there are no breakpoints or watchpoints.
+     * @return true if nothing to check
+     */
+    bool empty() const { return exec_count == 0 && watch_count == 0; }
+
+    bool is_set(uint16_t address) const { return test_bit(exec_bits, address); }
+    bool is_read_watched(uint16_t address) const { return test_bit(read_bits, address); }
+    bool is_write_watched(uint16_t address) const { return test_bit(write_bits, address); }
+
+    /**
+     * Get condition of breakpoint.
+     * @param address address of breakpoint
+     * @return condition, or nullptr for unconditional breakpoint
+     */
+    const Condition* get_condition(uint16_t address) const;
+
+    /**
+     * Record access to a watched address, for the CPU to break after the instruction.
+     * @param address accessed address
+     * @param value read or written value
+     * @param write true if write access
+     */
+    void trigger_watch(uint16_t address, uint8_t value, bool write);
+
+    // Last triggered watchpoint, watch_hit is reset by the CPU when it breaks.
+    bool watch_hit;
+    uint16_t watch_address;
+    uint8_t watch_value;
+    bool watch_write;
+
+protected:
+    static bool test_bit(const uint64_t* bits, uint16_t address)
+    {
+        return bits[address >> 6] & (uint64_t(1) << (address & 63));
+    }
+
+    static bool assign_bit(uint64_t* bits, uint16_t address, bool value);
+
+    /**
+     * Redirect page in the memory page tables if any address in it is watched.
+     * @param page page number
+     */
+    void update_page(uint8_t page);
+
+    Memory& memory;
+
+    uint64_t exec_bits[1024];
+    uint64_t read_bits[1024];
+    uint64_t write_bits[1024];
+
+    uint32_t exec_count;
+    uint32_t watch_count;
+
+    std::map<uint16_t, Condition> conditions;
+};
+
+#endif // BREAKPOINTS_H
@@ -16,7 +16,10 @@
 // =========================================================================
 
 #include <iostream>
+#include <algorithm>
 #include <bitset>
+#include <cmath>
+#include <cstring>
 #include <numeric>
 
 #include <machine.hpp>
@@ -113,6 +116,44 @@ constexpr uint8_t cycle_shift = 12;
 constexpr uint32_t cycles_per_second = 998400;
 constexpr uint32_t audio_frequency = 44100;
 
+// Band-limited step kernel, the impulse response of a windowed sinc lowpass for
+// each phase between two samples. Each phase sums to 1 << blep_shift, so levels
+// are exact once a step has passed.
+constexpr uint8_t blep_shift = 12;
+constexpr double blep_cutoff = 0.9;
+
+typedef std::array<std::array<int32_t, blep_taps>, blep_phases> BlepKernel;
+
+static BlepKernel make_blep_kernel()
+{
+    BlepKernel kernel{};
+    const double pi = 3.14159265358979323846;
+    const double half = blep_taps / 2;
+
+    for (uint8_t phase = 0; phase < blep_phases; ++phase) {
+        double taps[blep_taps];
+        double sum = 0;
+        for (uint8_t tap = 0; tap < blep_taps; ++tap) {
+            // Centered between tap half - 1 and half, by phase.
+            double x = tap - (half - 1) - double(phase) / blep_phases;
+            double sinc = x == 0 ? 1 : std::sin(pi * blep_cutoff * x) / (pi * blep_cutoff * x);
+            double window = 0.42 + 0.5 * std::cos(pi * x / half) + 0.08 * std::cos(2 * pi * x / half);
+            taps[tap] = sinc * window;
+            sum += taps[tap];
+        }
+
+        int32_t total = 0;
+        for (uint8_t tap = 0; tap < blep_taps; ++tap) {
+            kernel[phase][tap] = std::lround(taps[tap] / sum * (1 << blep_shift));
+            total += kernel[phase][tap];
+        }
+        kernel[phase][half - 1] += (1 << blep_shift) - total;
+    }
+    return kernel;
+}
+
+static const BlepKernel blep_kernel = make_blep_kernel();
+
 
 Channel::Channel() :
     volume(0),
@@ -153,6 +194,7 @@ Envelope::Envelope() :
     shape(0),
     shape_counter(0),
     out_level(0),
+    cont(false),
     hold(false),
     holding(false)
 {}
@@ -196,6 +238,16 @@ void RegisterChanges::exec()
     log_cycle++;
 }
 
+void RegisterChanges::exec(uint32_t cycles)
+{
+    if (update_log_cycle) {
+        log_cycle = new_log_cycle;
+        update_log_cycle = false;
+    }
+
+    log_cycle += cycles;
+}
+
 
 void AY3_8912::SoundState::reset()
 {
@@ -218,6 +270,11 @@ void AY3_8912::SoundState::reset()
     // Reset all tone and noise periods.
     for (auto& c : channels) { c.reset(); }
     noise.reset();
+
+    memset(blep_ring, 0, sizeof(blep_ring));
+    memset(blep_sums, 0, sizeof(blep_sums));
+    memset(blep_levels, 0, sizeof(blep_levels));
+    blep_index = 0;
 }
 
 void AY3_8912::SoundState::print_status()
@@ -349,62 +406,207 @@ void AY3_8912::SoundState::exec_register_change(RegisterChange& change)
     };
 }
 
+/**
+ * Get cycles until next event of a generator counter.
+ * @param counter counter
+ * @param period period, 0 counts as 1
+ * @return cycles until the counter wraps
+ */
+template <typename Counter>
+static uint32_t cycles_to_event(Counter counter, uint32_t period)
+{
+    // The counter may be above the period if it was just lowered.
+    return (counter + 1u >= period) ? 1 : period - counter;
+}
+
+/**
+ * Advance a generator counter a number of cycles. Each cycle the counter is
+ * incremented and wraps to 0 when it reaches the period, which is an event.
+ * @param counter counter to advance
+ * @param period period, 0 counts as 1
+ * @param cycles number of cycles
+ * @return number of events
+ */
+template <typename Counter>
+static uint32_t advance_counter(Counter& counter, uint32_t period, uint32_t cycles)
+{
+    uint32_t first = cycles_to_event(counter, period);
+    if (cycles < first) {
+        counter += cycles;
+        return 0;
+    }
+
+    uint32_t every = period ? period : 1;
+    uint32_t rest = cycles - first;
+    counter = rest % every;
+    return 1 + rest / every;
+}
+
 void AY3_8912::SoundState::exec_audio(uint32_t cycle)
 {
+    if (band_limited) {
+        exec_band_limited(cycle);
+        return;
+    }
+
+    exec_register_changes(cycle);
     if (cycle <= last_cycle) { return; }
 
     uint16_t cycles = cycle - last_cycle;
 
-    for (uint16_t c = 0; c < cycles; c++) {
-        // Tones
-        for (uint8_t channel = 0; channel < 3; channel++) {
-            if (++channels[channel].counter >= channels[channel].tone_period) {
-                channels[channel].counter = 0;
-                channels[channel].value ^= 1;
+    // Only the output of the last cycle is used, so each generator is advanced
+    // over all cycles at once.
+    advance(cycles);
+
+    uint32_t out = 0;
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        out += channel_level(channel);
+    }
+
+    if (out > 32767) { out = 32767; }
+    audio_out = out;
+
+    last_cycle = cycle;
+}
+
+void AY3_8912::SoundState::advance(uint32_t cycles)
+{
+    // Tones
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        channels[channel].value ^= advance_counter(channels[channel].counter, channels[channel].tone_period, cycles) & 1;
+    }
+
+    // Noise, the generator is stepped each time the bit toggles to 1.
+    uint32_t toggles = advance_counter(noise.counter, noise.period, cycles);
+    uint32_t steps = (toggles + ! noise.bit) / 2;
+    noise.bit ^= toggles & 1;
+    for (uint32_t step = 0; step < steps; step++) {
+        noise.rng ^= (((noise.rng & 1) ^ ((noise.rng >> 3) & 1)) << 17);
+        noise.rng >>= 1;
+    }
+
+    // Envelope
+    if (uint32_t events = advance_counter(envelope.counter, envelope.period, cycles)) {
+        if (! envelope.holding) {
+            // Shape counter holds when it reaches 0x1f, unless the shape continues.
+            uint32_t to_end = (0x1f - envelope.shape_counter) & 0x1f;
+            if (! envelope.cont || envelope.hold) {
+                if (to_end == 0) { to_end = 0x20; }
+                if (events >= to_end) {
+                    envelope.shape_counter = 0x1f;
+                    envelope.holding = true;
+                }
+                else {
+                    envelope.shape_counter += events;
+                }
+            }
+            else {
+                envelope.shape_counter = (envelope.shape_counter + events) % 0x20;
             }
         }
 
-        // Noise
-        if (++noise.counter >= noise.period) {
-            noise.counter = 0;
-            noise.bit ^= 1;
-            if (noise.bit) {
-                noise.rng ^= (((noise.rng & 1) ^ ((noise.rng >> 3) & 1)) << 17);
-                noise.rng >>= 1;
+        for (uint8_t channel = 0; channel < 3; channel++) {
+            if (channels[channel].use_envelope) {
+                channels[channel].volume = voltab[_ay38910_shapes[envelope.shape][envelope.shape_counter]];
             }
         }
+    }
+}
 
-        // Envelope
-        if (++envelope.counter >= envelope.period) {
-            envelope.counter = 0;
+uint32_t AY3_8912::SoundState::channel_level(uint8_t channel)
+{
+    return ((channels[channel].value | channels[channel].disabled) &
+            ((noise.rng & 1) | channels[channel].noise_diabled)) * channels[channel].volume;
+}
 
-            if (! envelope.holding) {
-                envelope.shape_counter = (envelope.shape_counter + 1) % 0x20;
-                if (envelope.shape_counter == 0x1f) {
-                    if (! envelope.cont || envelope.hold) {
-                        envelope.holding = true;
-                    }
-                }
-            }
+void AY3_8912::SoundState::exec_band_limited(uint32_t cycle)
+{
+    uint32_t cycles = cycle > last_cycle ? cycle - last_cycle : 0;
+
+    // Levels changed outside of the register change log since last sample.
+    add_level_steps(cycles);
+
+    bool noise_heard = false;
+    bool envelope_heard = false;
+    bool registers_changed = true;
+
+    // Step from one heard event or register change to the next, generators not heard are only counted.
+    uint32_t done = 0;
+    while (true) {
+        uint32_t at = last_cycle + done;
+        if (! changes.buffer.empty() && changes.buffer.front().cycle <= at) {
+            exec_register_changes(at);
+            add_level_steps(cycles - done);
+            registers_changed = true;
+        }
+        if (done >= cycles) {
+            break;
+        }
 
+        if (registers_changed) {
+            noise_heard = false;
+            envelope_heard = false;
             for (uint8_t channel = 0; channel < 3; channel++) {
-                if (channels[channel].use_envelope) {
-                    channels[channel].volume = voltab[_ay38910_shapes[envelope.shape][envelope.shape_counter]];
-                }
+                noise_heard |= ! channels[channel].noise_diabled;
+                envelope_heard |= channels[channel].use_envelope;
             }
+            registers_changed = false;
         }
 
-        uint32_t out = 0;
+        uint32_t step = cycles - done;
+        if (! changes.buffer.empty()) {
+            step = std::min(step, changes.buffer.front().cycle - at);
+        }
         for (uint8_t channel = 0; channel < 3; channel++) {
-            out += ((channels[channel].value | channels[channel].disabled) &
-                    ((noise.rng & 1) | channels[channel].noise_diabled)) * channels[channel].volume;
+            if (! channels[channel].disabled) {
+                step = std::min(step, cycles_to_event(channels[channel].counter, channels[channel].tone_period));
+            }
+        }
+        if (noise_heard) {
+            step = std::min(step, cycles_to_event(noise.counter, noise.period));
+        }
+        if (envelope_heard && ! envelope.holding) {
+            step = std::min(step, cycles_to_event(envelope.counter, envelope.period));
         }
 
-        if (out > 32767) { out = 32767; }
-        audio_out = out;
+        advance(step);
+        done += step;
+        add_level_steps(cycles - done);
     }
 
-    last_cycle = cycle;
+    // Sum impulses to levels and mix, the same for all channels.
+    int32_t* impulses = blep_ring[blep_index % blep_ring_size];
+    for (uint8_t lane = 0; lane < 4; lane++) {
+        blep_sums[lane] += impulses[lane];
+        impulses[lane] = 0;
+    }
+    int32_t out = (blep_sums[0] + blep_sums[1] + blep_sums[2]) >> blep_shift;
+
+    audio_out = std::clamp(out, 0, 32767);
+    ++blep_index;
+    last_cycle = std::max(cycle, last_cycle);
+}
+
+void AY3_8912::SoundState::add_level_steps(uint32_t cycles_ago)
+{
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        uint32_t level = channel_level(channel);
+        if (level == blep_levels[channel]) {
+            continue;
+        }
+        int32_t delta = level - blep_levels[channel];
+        blep_levels[channel] = level;
+
+        // Phases after previous sample, a change more than a sample ago is put on it.
+        uint32_t back = ((uint64_t(cycles_ago) << cycle_shift) * blep_phases + cycles_per_sample / 2) / cycles_per_sample;
+        uint32_t time = back < blep_phases ? blep_phases - back : 0;
+        uint32_t first = blep_index + time / blep_phases;
+        const std::array<int32_t, blep_taps>& kernel = blep_kernel[time % blep_phases];
+
+        for (uint8_t tap = 0; tap < blep_taps; tap++) {
+            blep_ring[(first + tap) % blep_ring_size][channel] += delta * kernel[tap];
+        }
+    }
 }
 
 
@@ -438,12 +640,22 @@ void AY3_8912::load_from_snapshot(Snapshot& snapshot)
     state = snapshot.ay3_8919;
 }
 
+void AY3_8912::set_band_limited(bool band_limited)
+{
+    state.band_limited = band_limited;
+}
+
 short AY3_8912::exec()
 {
     state.changes.exec();
     return 0;
 }
 
+void AY3_8912::exec(uint32_t cycles)
+{
+    state.changes.exec(cycles);
+}
+
 void AY3_8912::update_state()
 {
     if (state.bdir) {
@@ -475,9 +687,14 @@ void AY3_8912::update_state()
                 case ENV_DURATION_HIGH:
                 case ENV_SHAPE:
                     if (! machine.warpmode_on) {
-                        machine.frontend->lock_audio();
-                        state.write_register_change(value);
-                        machine.frontend->unlock_audio();
+                        if (machine.frontend) {
+                            machine.frontend->lock_audio();
+                            state.write_register_change(value);
+                            machine.frontend->unlock_audio();
+                        }
+                        else {
+                            state.write_register_change(value);
+                        }
                     }
                     break;
                 case IO_PORT_A:
@@ -540,7 +757,6 @@ void AY3_8912::audio_callback(void* user_data, uint8_t* raw_buffer, int len)
     for (size_t sample = 0; sample < samples; sample++) {
         uint32_t current_cycle = ay->state.cycle_count >> cycle_shift;
 
-        ay->state.exec_register_changes(current_cycle);
         ay->state.exec_audio(current_cycle);
 
         buffer[current_sample++] = ay->state.audio_out;
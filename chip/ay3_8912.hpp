@@ -30,6 +30,12 @@ typedef uint8_t (*f_write_data_handler)(Machine &oric);
 
 constexpr size_t register_changes_size = 32768;
 
+// Band-limited synthesis: taps and phases of step kernel, and ring of samples
+// steps are added to.
+constexpr uint8_t blep_taps = 16;
+constexpr uint8_t blep_phases = 32;
+constexpr uint8_t blep_ring_size = 32;
+
 
 class Channel
 {
@@ -119,6 +125,12 @@ public:
     void reset();
     void exec();
 
+    /**
+     * Advance log cycle a number of cycles.
+     * @param cycles number of cycles to advance
+     */
+    void exec(uint32_t cycles);
+
     boost::circular_buffer<RegisterChange> buffer;
 
     uint32_t new_log_cycle;
@@ -166,7 +178,7 @@ public:
          * @param cycle current cycle
          */
         void exec_register_changes(uint32_t cycle) {
-            while (cycle >= changes.buffer[0].cycle && !changes.buffer.empty()) {
+            while (!changes.buffer.empty() && cycle >= changes.buffer[0].cycle) {
                 exec_register_change(changes.buffer[0]);
                 changes.buffer.pop_front();
             }
@@ -184,11 +196,38 @@ public:
         void trim_register_changes();
 
         /**
-         * Execute audio a number of clock cycles.
+         * Execute register changes and audio a number of clock cycles. Band-limited
+         * synthesis makes one sample per call.
          * @param cycle number of cycles to execute.
          */
         void exec_audio(uint32_t cycle);
 
+        /**
+         * Advance tone, noise and envelope generators.
+         * @param cycles number of cycles to advance
+         */
+        void advance(uint32_t cycles);
+
+        /**
+         * Get current output level of a channel.
+         * @param channel channel number
+         * @return output level
+         */
+        uint32_t channel_level(uint8_t channel);
+
+        /**
+         * Execute audio up to cycle, making one band-limited sample. Register
+         * changes are executed at their cycle between generator events.
+         * @param cycle cycle of sample
+         */
+        void exec_band_limited(uint32_t cycle);
+
+        /**
+         * Add band-limited steps for channels with changed output level.
+         * @param cycles_ago cycles before current sample of the change
+         */
+        void add_level_steps(uint32_t cycles_ago);
+
         bool bdir;
         bool bc1;
         bool bc2;
@@ -206,6 +245,14 @@ public:
         uint32_t cycles_per_sample;
         uint32_t cycle_count;
         uint32_t last_cycle;
+
+        // Band-limited synthesis. Steps are added to the ring as impulses per
+        // channel, which are summed to levels when the sample is made.
+        bool band_limited = false;
+        alignas(16) int32_t blep_ring[blep_ring_size][4];
+        alignas(16) int32_t blep_sums[4];
+        uint32_t blep_levels[3];
+        uint32_t blep_index;
     };
 
 
@@ -234,11 +281,23 @@ public:
      */
     void load_from_snapshot(Snapshot& snapshot);
 
+    /**
+     * Use band-limited synthesis instead of point sampling the output.
+     * @param band_limited true for band-limited synthesis
+     */
+    void set_band_limited(bool band_limited);
+
     /**
      * Execute a number of clock cycles.
      */
     short exec();
 
+    /**
+     * Execute a number of clock cycles in one step.
+     * @param cycles number of cycles to execute
+     */
+    void exec(uint32_t cycles);
+
     /**
      * Update AY state based on BC1 and BDIR.
      */
@@ -22,102 +22,74 @@
 #include "snapshot.hpp"
 
 #include "mos6502.hpp"
+#include "mos6502_bus.hpp"
 #include "mos6502_opcodes.hpp"
-#include "mos6502_cycles.hpp"
+#include "mos6502_opcode_table.hpp"
 
 
-// Macros for addressing modes
-#define READ_BYTE_IMM()     memory_read_byte_handler(machine, PC++)
-
-// Read addresses
-#define READ_ADDR_ZP()      (READ_BYTE_IMM())
-#define READ_ADDR_ZP_X()    ((READ_BYTE_IMM() + X) & 0xff)
-#define READ_ADDR_ZP_Y()    ((READ_BYTE_IMM() + Y) & 0xff)
-
-#define READ_ADDR_ABS()    addr = READ_BYTE_IMM(); addr += READ_BYTE_IMM() << 8
-#define READ_ADDR_ABS_X()   READ_ADDR_ABS(); addr += X
-#define READ_ADDR_ABS_Y()   READ_ADDR_ABS(); addr += Y
-
-// Direct assigning versions with page check
+// Page crossing checks for timing.
 #define PAGECHECK(n) (((addr + n) & 0xff00) != (addr & 0xff00))
 #define PAGECHECK2(a, b) ((a & 0xff00) != (b & 0xff00))
 
-#define READ_ADDR_IND_X()   (memory_read_word_zp_handler(machine, READ_BYTE_IMM() + X))
-#define READ_ADDR_IND_Y()   (memory_read_word_zp_handler(machine, READ_BYTE_IMM()) + Y)
-
-#define READ_JUMP_ADDR()    (b1 = READ_BYTE_IMM(), b1 & 0x80 ? (PC - ((b1 ^ 0xff)+1)) : (PC + b1))
-#define PEEK_JUMP_ADDR(pc)    (b1 = memory_read_byte_handler(machine, pc+1), b1 & 0x80 ? (pc + 2 - ((b1 ^ 0xff)+1)) : (pc + 2 + b1))
-
-// Read data
-#define READ_BYTE_ZP()      memory_read_byte_zp_handler(machine, READ_ADDR_ZP())
-#define READ_BYTE_ZP_X()    memory_read_byte_zp_handler(machine, READ_ADDR_ZP_X())
-#define READ_BYTE_ZP_Y()    memory_read_byte_zp_handler(machine, READ_ADDR_ZP_Y())
-
-#define READ_BYTE_ABS(b)   READ_ADDR_ABS(); b = memory_read_byte_handler(machine, addr)
-
-#define READ_BYTE_IND_X()   memory_read_byte_handler(machine, READ_ADDR_IND_X())
-#define READ_BYTE_IND_Y()   memory_read_byte_handler(machine, READ_ADDR_IND_Y())
-
 #define PUSH_BYTE_STACK(b)  (memory.mem[STACK_BOTTOM | (SP--)] = (b))
 #define POP_BYTE_STACK()    (memory.mem[STACK_BOTTOM | (++SP)])
 
 // Macros for flag handling
-#define SET_FLAG_NZ(B)     (N_INTERN = Z_INTERN = B)
+#define SET_FLAG_NZ(B)     (flags.n = flags.z = B)
 
-#define Z	(!Z_INTERN)
-#define N	(!!(N_INTERN & 0x80))
+#define Z	(!flags.z)
+#define N	(!!(flags.n & FLAG_N))
+#define V	(!!(flags.v & FLAG_V))
+#define C	((flags.c >> 8) & 1)
+#define D	(flags.p & FLAG_D)
+#define I	(flags.p & FLAG_I)
 
 
-MOS6502::MOS6502(Machine& a_Machine) :
+template <typename Bus>
+MOS6502<Bus>::MOS6502(const Bus& a_bus) :
+    instruction_count(0),
     A(0),
     X(0),
     Y(0),
-    N_INTERN(0),
-    Z_INTERN(0),
-    V(false),
-    B(false),
-    D(false),
-    I(false),
-    C(false),
+    flags(),
+    breakpoints(a_bus.memory),
+    trace(nullptr),
+    profiler(nullptr),
+    bus(a_bus),
+    memory(a_bus.memory),
     PC(0),
     SP(0),
-    quiet(true),
-    machine(a_Machine),
     irq_flag(false),
     nmi_flag(false),
     do_interrupt(false),
     do_nmi(false),
-    memory_read_byte_handler(nullptr),
-    memory_read_byte_zp_handler(nullptr),
-    memory_read_word_handler(nullptr),
-    memory_read_word_zp_handler(nullptr),
-    memory_write_byte_handler(nullptr),
-    memory_write_byte_zp_handler(nullptr),
-    memory(a_Machine.memory),
     instruction_load(true),
     instruction_cycles(0),
     current_instruction(0),
+    current_operand(0),
     current_cycle(0),
-    monitor(memory),
-    has_breakpoints(false)
+    cycles_ahead(0),
+    data_latch(0),
+    decode_cache(0x10000),
+    decoded_uncached(),
+    trap_handler(nullptr),
+    traps(0x10000),
+    monitor(memory)
 {
 }
 
 
-void MOS6502::Reset()
+template <typename Bus>
+void MOS6502<Bus>::Reset()
 {
+    instruction_count = 0;
     A = 0;
     X = 0;
     Y = 0;
-    N_INTERN = 0;
-    Z_INTERN = 0;
-    V = false;
-    B = false;
-    D = false;
-    I = true;	// Block interrupts after reset.
-    C = false;
-
-    PC = memory_read_byte_handler(machine, RESET_VECTOR_L) + (memory_read_byte_handler(machine, RESET_VECTOR_H) << 8);
+    flags = {};
+    flags.p = FLAG_I;	// Block interrupts after reset.
+
+    PC = bus.read_byte(RESET_VECTOR_L) + (bus.read_byte(RESET_VECTOR_H) << 8);
     SP = 0xff;
     irq_flag = false;
     nmi_flag = false;
@@ -127,21 +99,19 @@ void MOS6502::Reset()
     instruction_load = true;
     instruction_cycles = 0;
     current_instruction = 0;
+    current_operand = 0;
     current_cycle = 0;
+    cycles_ahead = 0;
+    data_latch = 0;
 }
 
-void MOS6502::save_to_snapshot(Snapshot& snapshot)
+template <typename Bus>
+void MOS6502<Bus>::save_to_snapshot(Snapshot& snapshot)
 {
     snapshot.mos6502.A = A;
     snapshot.mos6502.X = X;
     snapshot.mos6502.Y = Y;
-    snapshot.mos6502.N_INTERN = N_INTERN;
-    snapshot.mos6502.Z_INTERN = Z_INTERN;
-    snapshot.mos6502.V = V;
-    snapshot.mos6502.B = B;
-    snapshot.mos6502.D = D;
-    snapshot.mos6502.I = I;
-    snapshot.mos6502.C = C;
+    snapshot.mos6502.flags = flags;
 
     snapshot.mos6502.PC = PC;
     snapshot.mos6502.SP = SP;
@@ -153,21 +123,18 @@ void MOS6502::save_to_snapshot(Snapshot& snapshot)
     snapshot.mos6502.instruction_load = instruction_load;
     snapshot.mos6502.instruction_cycles = instruction_cycles;
     snapshot.mos6502.current_instruction = current_instruction;
+    snapshot.mos6502.current_operand = current_operand;
     snapshot.mos6502.current_cycle = current_cycle;
+    snapshot.mos6502.data_latch = data_latch;
 }
 
-void MOS6502::load_from_snapshot(Snapshot& snapshot)
+template <typename Bus>
+void MOS6502<Bus>::load_from_snapshot(Snapshot& snapshot)
 {
     A = snapshot.mos6502.A;
     X = snapshot.mos6502.X;
     Y = snapshot.mos6502.Y;
-    N_INTERN = snapshot.mos6502.N_INTERN;
-    Z_INTERN = snapshot.mos6502.Z_INTERN;
-    V = snapshot.mos6502.V;
-    B = snapshot.mos6502.B;
-    D = snapshot.mos6502.D;
-    I = snapshot.mos6502.I;
-    C = snapshot.mos6502.C;
+    flags = snapshot.mos6502.flags;
 
     PC = snapshot.mos6502.PC;
     SP = snapshot.mos6502.SP;
@@ -179,22 +146,19 @@ void MOS6502::load_from_snapshot(Snapshot& snapshot)
     instruction_load = snapshot.mos6502.instruction_load;
     instruction_cycles = snapshot.mos6502.instruction_cycles;
     current_instruction = snapshot.mos6502.current_instruction;
+    current_operand = snapshot.mos6502.current_operand;
     current_cycle = snapshot.mos6502.current_cycle;
+    data_latch = snapshot.mos6502.data_latch;
 }
 
-void MOS6502::set_breakpoint(uint16_t address)
-{
-    breakpoints.insert(address);
-    has_breakpoints = true;
-    std::cout << "Set breakpoint at $" << std::hex << address << std::endl;
-}
-
-void MOS6502::PrintStat()
+template <typename Bus>
+void MOS6502<Bus>::PrintStat()
 {
     PrintStat(PC);
 }
 
-void MOS6502::PrintStat(uint16_t address)
+template <typename Bus>
+void MOS6502<Bus>::PrintStat(uint16_t address)
 {
     std::cout << monitor.disassemble(address) << " ";
     printf("A: %02X, X: %02X, Y: %02X  |  N: %d, Z: %d, C: %d, V: %d  |  SP: %02X\n",
@@ -205,1050 +169,893 @@ void MOS6502::PrintStat(uint16_t address)
 // +---+---+---+---+---+---+---+---+
 // | N | V |   | B | D | I | Z | C |
 // +---+---+---+---+---+---+---+---+
-uint8_t MOS6502::get_p()
+template <typename Bus>
+uint8_t MOS6502<Bus>::get_p()
 {
-    uint8_t result = 0;
-    result |= N ? FLAG_N : 0;
-    result |= V ? FLAG_V : 0;
-    result |= B ? FLAG_B : 0;
-    result |= D ? FLAG_D : 0;
-    result |= I ? FLAG_I : 0;
-    result |= Z ? FLAG_Z : 0;
-    result |= C ? FLAG_C : 0;
-    return result;
+    return (flags.n & FLAG_N) | (flags.v & FLAG_V) | flags.p | (flags.z ? 0 : FLAG_Z) | C;
 }
 
-void MOS6502::set_p(uint8_t p)
+template <typename Bus>
+void MOS6502<Bus>::set_p(uint8_t p)
 {
-    N_INTERN = (p & FLAG_N) ? FLAG_N : 0;
-    V = !! (p & FLAG_V);
-    B = !! (p & FLAG_B);
-    D = !! (p & FLAG_D);
-    I = !! (p & FLAG_I);
-    Z_INTERN = (p & FLAG_Z) ? 0 : 1;
-    C = !! (p & FLAG_C);
+    flags.n = p;
+    flags.v = p;
+    flags.p = p & (FLAG_B | FLAG_D | FLAG_I);
+    flags.z = ~p & FLAG_Z;
+    flags.c = p << 8;
 }
 
-void MOS6502::ADC(uint8_t value)
+template <typename Bus>
+void MOS6502<Bus>::set_registers(const Registers& registers)
 {
-    if (D) { // Decimal mode
-        uint16_t low = (A & 0x0f) + (value & 0x0f) + (C ? 1 : 0);
-        if (low > 9) low += 6;    // 11 + 6 = (0xb + 6) = 0x11
-        uint16_t high = (A >> 4) + (value >> 4) + (low > 0x0f);	// remainder from low figure -> high
+    PC = registers.pc;
+    A = registers.a;
+    X = registers.x;
+    Y = registers.y;
+    set_p(registers.p);
+    SP = registers.sp;
+}
 
-        Z_INTERN = (A + value + (C ? 1 : 0)) & 0xff;
-        N_INTERN = (high & 0x08) ? FLAG_N : 0;
-        V = ~(A ^ value) & (A ^ (high << 4)) & 0x80;
 
-        if (high > 9) high += 6;  // 11 + 6 = (0xb + 6) = 0x11
-        C = high > 0x0f;
-        A = (high << 4) | (low & 0x0f);
+template <typename Bus>
+bool MOS6502<Bus>::is_idle_instruction()
+{
+    if (! instruction_load) {
+        return false;
     }
-    else { // Normal mode
-        uint16_t w = A + value + (C ? 1 : 0);
-        C = w > 0xff;
-        V = ~(A ^ value) & (A ^ w) & 0x80;
-        SET_FLAG_NZ(A = w);
+
+    const DecodedInstruction& decoded = decode(PC);
+    uint16_t operand = decoded.operand;
+    uint16_t address;
+
+    switch (decoded.opcode)
+    {
+        case NOP:
+        case CLC: case SEC: case CLI: case SEI: case CLV: case CLD: case SED:
+        case TAX: case TAY: case TXA: case TYA: case TSX: case TXS:
+        case INX: case INY: case DEX: case DEY:
+        case ASL_ACC: case LSR_ACC: case ROL_ACC: case ROR_ACC:
+        case PLA: case PLP: case RTS: case JSR:
+        case BPL: case BMI: case BVC: case BVS: case BCC: case BCS: case BNE: case BEQ:
+        case JMP_ABS:
+        case LDA_IMM: case LDX_IMM: case LDY_IMM:
+        case ADC_IMM: case SBC_IMM: case AND_IMM: case ORA_IMM: case EOR_IMM:
+        case CMP_IMM: case CPX_IMM: case CPY_IMM:
+            return true;
+
+        case LDA_ZP: case LDX_ZP: case LDY_ZP:
+        case ADC_ZP: case SBC_ZP: case AND_ZP: case ORA_ZP: case EOR_ZP:
+        case CMP_ZP: case CPX_ZP: case CPY_ZP: case BIT_ZP:
+            address = operand & 0xff;
+            break;
+
+        case LDA_ZP_X: case LDY_ZP_X:
+        case ADC_ZP_X: case SBC_ZP_X: case AND_ZP_X: case ORA_ZP_X: case EOR_ZP_X: case CMP_ZP_X:
+            address = (operand + X) & 0xff;
+            break;
+
+        case LDX_ZP_Y:
+            address = (operand + Y) & 0xff;
+            break;
+
+        case LDA_ABS: case LDX_ABS: case LDY_ABS:
+        case ADC_ABS: case SBC_ABS: case AND_ABS: case ORA_ABS: case EOR_ABS:
+        case CMP_ABS: case CPX_ABS: case CPY_ABS: case BIT_ABS:
+            address = operand;
+            break;
+
+        case LDA_ABS_X: case LDY_ABS_X:
+        case ADC_ABS_X: case SBC_ABS_X: case AND_ABS_X: case ORA_ABS_X: case EOR_ABS_X: case CMP_ABS_X:
+            address = operand + X;
+            break;
+
+        case LDA_ABS_Y: case LDX_ABS_Y:
+        case ADC_ABS_Y: case SBC_ABS_Y: case AND_ABS_Y: case ORA_ABS_Y: case EOR_ABS_Y: case CMP_ABS_Y:
+            address = operand + Y;
+            break;
+
+        case LDA_IND_X:
+        case ADC_IND_X: case SBC_IND_X: case AND_IND_X: case ORA_IND_X: case EOR_IND_X: case CMP_IND_X:
+            if (! memory.read_pages[0]) {
+                return false;
+            }
+            address = bus.read_word_zp(operand + X);
+            break;
+
+        case LDA_IND_Y:
+        case ADC_IND_Y: case SBC_IND_Y: case AND_IND_Y: case ORA_IND_Y: case EOR_IND_Y: case CMP_IND_Y:
+            if (! memory.read_pages[0]) {
+                return false;
+            }
+            address = bus.read_word_zp(operand) + Y;
+            break;
+
+        case JMP_IND:
+            address = operand;
+            break;
+
+        default:
+            return false;
     }
+
+    // Pages without a direct mapping are I/O or watched, where reading has effects.
+    return memory.read_pages[address >> 8] != nullptr;
 }
 
-void MOS6502::SBC(uint8_t value)
+
+template <typename Bus>
+void MOS6502<Bus>::set_trap_handler(f_trap_handler handler)
 {
-    if (D) {
-        uint16_t low = (A & 0x0f) - (value & 0x0f) - (C ? 0 : 1);
-        uint16_t high = (A >> 4) - (value >> 4);
+    if (handler == trap_handler) {
+        return;
+    }
+    trap_handler = handler;
 
-        if (low & 0x10) { // Fix negative
-            low -= 6;
-            --high;
-        }
-        if (high & 0x10) { // Fix negative
-            high -= 6;
-        }
+    // Decoded instructions must be trapped or not according to the new handler.
+    for (auto& generation : memory.page_generation) {
+        ++generation;
+    }
+}
 
-        uint16_t w = SET_FLAG_NZ(A - value - (C ? 0 : 1));
-        C = w < 0x100;
-        V = (A ^ value) & (A ^ w) & 0x80;
-        A = (high << 4) | (low & 0x0f);
+
+template <typename Bus>
+void MOS6502<Bus>::set_trap(uint16_t address, bool trap)
+{
+    traps[address] = trap;
+    ++memory.page_generation[address >> 8];
+}
+
+
+template <typename Bus>
+void MOS6502<Bus>::set_alu_result(const AluResult& result)
+{
+    A = result.value;
+    flags.n = result.flags;
+    flags.z = ~result.flags & FLAG_Z;
+    flags.v = result.flags;
+    flags.c = (result.flags & FLAG_C) << 8;
+}
+
+template <typename Bus>
+void MOS6502<Bus>::add(uint8_t value)
+{
+    flags.c = A + value + C;
+    flags.v = ((A ^ flags.c) & (value ^ flags.c) & 0x80) >> 1;
+    SET_FLAG_NZ(A = flags.c);
+}
+
+template <typename Bus>
+void MOS6502<Bus>::ADC(uint8_t value)
+{
+    if (D) {
+        set_alu_result(adc_decimal_table[alu_index(C, A, value)]);
     }
     else {
-        uint16_t w = A - value - (C ? 0 : 1);
-        C = w < 0x100;
-        V = (A ^ value) & (A ^ w) & 0x80;
-        SET_FLAG_NZ(A = w);
+        add(value);
     }
+}
 
-    //std::cout << "A now: " << hex << A << std::std::endl;
+template <typename Bus>
+void MOS6502<Bus>::SBC(uint8_t value)
+{
+    if (D) {
+        set_alu_result(sbc_decimal_table[alu_index(C, A, value)]);
+    }
+    else {
+        // Binary subtraction is addition of the complement, with carry as inverted borrow.
+        add(~value);
+    }
 }
 
 
-#define PEEK_ADDR_ABS()     (memory_read_byte_handler(machine, _pc + 1) | memory_read_byte_handler(machine, _pc + 2) << 8)
+template <typename Bus>
+const typename MOS6502<Bus>::DecodedInstruction& MOS6502<Bus>::decode(uint16_t pc)
+{
+    uint8_t page = pc >> 8;
+    DecodedInstruction& cached = decode_cache[pc];
+    if (cached.generation == memory.page_generation[page]) {
+        return cached;
+    }
+
+    // Instructions reaching into next page are not cached, since that page may be remapped separately.
+    bool cache = (pc & 0xff) <= 0xfd && memory.is_read_only(page);
+    DecodedInstruction& decoded = cache ? cached : decoded_uncached;
+
+    decoded.opcode = bus.read_byte(pc);
+    const OpcodeInfo& info = opcode_table[decoded.opcode];
+    decoded.operand = info.length > 1 ? bus.read_byte(pc + 1) : 0;
+    if (info.length > 2) {
+        decoded.operand |= bus.read_byte(pc + 2) << 8;
+    }
 
+    decoded.cycles = info.cycles;
+    decoded.timing = info.timing;
+    if (trap_handler && traps[pc] && decoded.timing == TIMING_FIXED) {
+        decoded.opcode = HLE_TRAP;
+    }
+    if (decoded.timing == TIMING_BRANCH) {
+        uint16_t next = pc + 2;
+        uint16_t target = next + (int8_t)decoded.operand;
+        decoded.branch_cycles = PAGECHECK2(target, next) ? 2 : 1;
+    }
+
+    decoded.generation = cache ? memory.page_generation[page] : 0;
+    return decoded;
+}
 
-uint8_t MOS6502::time_instruction()
+
+template <typename Bus>
+uint8_t MOS6502<Bus>::time_instruction()
 {
     uint16_t _pc = PC;
     uint8_t extra = 0;
 
     if (nmi_flag) {
-        _pc = memory_read_word_handler(machine, NMI_VECTOR_L);
+        _pc = bus.read_word(NMI_VECTOR_L);
         extra += 7;
         do_interrupt = true;
     }
     else if (irq_flag && !I) {
-        _pc = memory_read_word_handler(machine, IRQ_VECTOR_L);
+        _pc = bus.read_word(IRQ_VECTOR_L);
         extra += 7;
         do_interrupt = true;
     }
 
-    uint8_t b1;
+    const DecodedInstruction& decoded = decode(_pc);
+    current_instruction = decoded.opcode;
+    current_operand = decoded.operand;
+
     uint16_t addr;
-    current_instruction = memory_read_byte_handler(machine, _pc);
+    bool taken;
 
-    switch(current_instruction)
+    switch(decoded.timing)
     {
-        case LDA_ABS_X:
-        case LDY_ABS_X:
-        case ADC_ABS_X:
-        case SBC_ABS_X:
-        case AND_ABS_X:
-        case ORA_ABS_X:
-        case EOR_ABS_X:
-        case CMP_ABS_X:
-        case ILL_NOP_ABS_X_1C:
-        case ILL_NOP_ABS_X_3C:
-        case ILL_NOP_ABS_X_5C:
-        case ILL_NOP_ABS_X_7C:
-        case ILL_NOP_ABS_X_DC:
-        case ILL_NOP_ABS_X_FC:
-            addr = PEEK_ADDR_ABS();
-            extra += PAGECHECK(X) ? 1 : 0;
+        case TIMING_ABS_X:
+            extra += PAGECHECK2(decoded.operand, (decoded.operand + X)) ? 1 : 0;
             break;
 
-        case LDA_ABS_Y:
-        case LDX_ABS_Y:
-        case ADC_ABS_Y:
-        case SBC_ABS_Y:
-        case AND_ABS_Y:
-        case ORA_ABS_Y:
-        case EOR_ABS_Y:
-        case CMP_ABS_Y:
-            addr = PEEK_ADDR_ABS();
-            extra += PAGECHECK(Y) ? 1 : 0;
+        case TIMING_ABS_Y:
+            extra += PAGECHECK2(decoded.operand, (decoded.operand + Y)) ? 1 : 0;
             break;
 
-        case LDA_IND_Y:
-        case ADC_IND_Y:
-        case SBC_IND_Y:
-        case AND_IND_Y:
-        case ORA_IND_Y:
-        case EOR_IND_Y:
-        case CMP_IND_Y:
-            addr = memory_read_word_zp_handler(machine, memory_read_byte_handler(machine, _pc + 1));
+        case TIMING_IND_Y:
+            addr = bus.read_word_zp(decoded.operand);
             extra += PAGECHECK(Y) ? 1 : 0;
             break;
 
-
-        case BCC:
-            if (!C) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
-            }
-            break;
-        case BCS:
-            if (C) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
+        case TIMING_BRANCH:
+            switch(decoded.opcode)
+            {
+                case BCC: taken = !C; break;
+                case BCS: taken = C; break;
+                case BEQ: taken = Z; break;
+                case BNE: taken = !Z; break;
+                case BMI: taken = N; break;
+                case BPL: taken = !N; break;
+                case BVC: taken = !V; break;
+                default:  taken = V; break;  // BVS
             }
-            break;
-        case BEQ:
-            if (Z) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
-            }
-            break;
-        case BNE:
-            if (!Z) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
+            if (taken) {
+                extra += decoded.branch_cycles;
             }
             break;
 
-        case BMI:
-            if (N) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
-            }
-            break;
-
-        case BPL:
-            if (!N) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
-            }
-            break;
-
-        case BVC:
-            if (!V) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
-            }
-            break;
-
-        case BVS:
-            if (V) {
-                addr = PEEK_JUMP_ADDR(_pc);
-                extra += PAGECHECK2(addr, (_pc + 2)) ? 2 : 1;
-            }
-            break;
         default:
             break;
     }
 
-    return opcode_cycles[current_instruction] + extra;
+    return decoded.cycles + extra;
 }
 
 
-bool MOS6502::exec(bool& do_break)
+template <typename Bus>
+template <bool Debug>
+bool MOS6502<Bus>::load_instruction(bool& do_break)
 {
-    if (instruction_load) {
-        instruction_load = false;
+    instruction_load = false;
 
-        current_cycle = 0;
-        instruction_cycles = time_instruction();
+    if (Debug) {
+        // Forget watchpoints triggered while not checking them, like when stepping.
+        breakpoints.watch_hit = false;
+    }
 
-        if (do_interrupt) {
-            do_interrupt = false;
+    current_cycle = 0;
+    instruction_cycles = time_instruction();
 
-            PUSH_BYTE_STACK(PC >> 8);
-            PUSH_BYTE_STACK(PC & 0xff);
-            PUSH_BYTE_STACK(get_p());
+    if (do_interrupt) {
+        do_interrupt = false;
 
-            if (nmi_flag) {
-                PC = memory_read_word_handler(machine, NMI_VECTOR_L);
-                nmi_flag = false;
-                std::cout << "NMI interrupt" << std::endl;
-            }
+        PUSH_BYTE_STACK(PC >> 8);
+        PUSH_BYTE_STACK(PC & 0xff);
+        PUSH_BYTE_STACK(get_p());
 
-            else if (irq_flag) {
-                I = true;
-                PC = memory_read_word_handler(machine, IRQ_VECTOR_L);
-                irq_flag = false;
-            }
+        if (nmi_flag) {
+            PC = bus.read_word(NMI_VECTOR_L);
+            nmi_flag = false;
+            std::cout << "NMI interrupt" << std::endl;
         }
 
-        if (has_breakpoints && breakpoints.contains(PC)) {
-            std::cout << "Found breakpoint at $" << std::hex << PC << std::endl;
-            do_break = true;
-            return false;
+        else if (irq_flag) {
+            flags.p |= FLAG_I;
+            PC = bus.read_word(IRQ_VECTOR_L);
+            irq_flag = false;
         }
     }
 
-    if (++current_cycle < instruction_cycles) {
-//        std::cout << " -- current cycle: " << (int)current_cycle << std::endl;
+    if (Debug && breakpoints.is_set(PC) && breakpoint_condition_met()) {
+        std::cout << "Found breakpoint at $" << std::hex << PC << std::endl;
+        do_break = true;
         return false;
     }
 
-//    std::cout << " -- Exec (" << (int)instruction_cycles << " cycles)" << std::endl;
-    uint8_t b1, b2;
-    uint16_t addr;
-    int i;
+    if (Debug && trace) {
+        trace->record({0, PC, current_instruction, (uint8_t)current_operand, (uint8_t)(current_operand >> 8),
+                       A, X, Y, get_p(), SP, {}});
+    }
 
-    uint16_t pc_initial = PC;
-//    uint8_t instruction = READ_BYTE_IMM();
+    if (Debug && profiler) {
+        profiler->record(PC, current_instruction, instruction_cycles);
+    }
 
-    instruction_load = true;
-    ++PC;
+    return true;
+}
 
-    switch(current_instruction)
-    {
-        case LDA_IMM:
-            SET_FLAG_NZ(A = READ_BYTE_IMM());
-            break;
-        case LDA_ZP:
-            SET_FLAG_NZ(A = READ_BYTE_ZP());
-            break;
-        case LDA_ZP_X:
-            SET_FLAG_NZ(A = READ_BYTE_ZP_X());
-            break;
-        case LDA_ABS:
-            READ_BYTE_ABS(A);
-            SET_FLAG_NZ(A);
-            break;
-        case LDA_ABS_X:
-            READ_ADDR_ABS_X();
-            SET_FLAG_NZ(A = memory_read_byte_handler(machine, addr));
-            break;
-        case LDA_ABS_Y:
-            READ_ADDR_ABS_Y();
-            SET_FLAG_NZ(A = memory_read_byte_handler(machine, addr));
-            break;
-        case LDA_IND_X:
-            SET_FLAG_NZ(A = READ_BYTE_IND_X());
-            break;
-        case LDA_IND_Y:
-            addr = READ_ADDR_IND_Y();
-            SET_FLAG_NZ(A = memory_read_byte_handler(machine, addr));
-            break;
 
-        case LDX_IMM:
-            SET_FLAG_NZ(X = READ_BYTE_IMM());
-            break;
-        case LDX_ZP:
-            SET_FLAG_NZ(X = READ_BYTE_ZP());
-            break;
-        case LDX_ZP_Y:
-            SET_FLAG_NZ(X = READ_BYTE_ZP_Y());
-            break;
-        case LDX_ABS:
-            READ_BYTE_ABS(b1);
-            SET_FLAG_NZ(X = b1);
-            break;
-        case LDX_ABS_Y:
-            READ_ADDR_ABS_Y();
-            SET_FLAG_NZ(X = memory_read_byte_handler(machine, addr));
-            break;
+template <typename Bus>
+bool MOS6502<Bus>::breakpoint_condition_met()
+{
+    const Breakpoints::Condition* condition = breakpoints.get_condition(PC);
+    if (! condition) {
+        return true;
+    }
 
-            
-        case LDY_IMM:
-            SET_FLAG_NZ(Y = READ_BYTE_IMM());
-            break;
-        case LDY_ZP:
-            SET_FLAG_NZ(Y = READ_BYTE_ZP());
-            break;
-        case LDY_ZP_X:
-            SET_FLAG_NZ(Y = READ_BYTE_ZP_X());
-            break;
-        case LDY_ABS:
-            READ_BYTE_ABS(b1);
-            SET_FLAG_NZ(Y = b1);
-            break;
-        case LDY_ABS_X:
-            READ_ADDR_ABS_X();
-            SET_FLAG_NZ(Y = memory_read_byte_handler(machine, addr));
-            break;
+    switch (condition->source) {
+        case Breakpoints::SOURCE_A: return condition->test(A);
+        case Breakpoints::SOURCE_X: return condition->test(X);
+        case Breakpoints::SOURCE_Y: return condition->test(Y);
+        case Breakpoints::SOURCE_P: return condition->test(get_p());
+        case Breakpoints::SOURCE_MEMORY: return condition->test(memory.mem[condition->address]);
+    }
+    return true;
+}
 
-        case STA_ZP:
-            memory_write_byte_handler(machine, READ_ADDR_ZP(), A);
-            break;
-        case STA_ZP_X:
-            memory_write_byte_handler(machine, READ_ADDR_ZP_X(), A);
-            break;
-        case STA_ABS:
-            READ_ADDR_ABS();
-            memory_write_byte_handler(machine, addr, A);
-            break;
-        case STA_ABS_X:
-            READ_ADDR_ABS_X();
-            memory_write_byte_handler(machine, addr, A);
-            break;
-        case STA_ABS_Y:
-            READ_ADDR_ABS_Y();
-            memory_write_byte_handler(machine, addr, A);
-            break;
-        case STA_IND_X:
-            memory_write_byte_handler(machine, READ_ADDR_IND_X(), A);
-            break;
-        case STA_IND_Y:
-            memory_write_byte_handler(machine, READ_ADDR_IND_Y(), A);
-            break;
 
-        case STX_ZP:
-            memory_write_byte_handler(machine, READ_ADDR_ZP(), X);
-            break;
-        case STX_ZP_Y:
-            memory_write_byte_handler(machine, READ_ADDR_ZP_Y(), X);
-            break;
-        case STX_ABS:
-            READ_ADDR_ABS();
-            memory_write_byte_handler(machine, addr, X);
-            break;
+template <typename Bus>
+void MOS6502<Bus>::check_watch(bool& do_break)
+{
+    if (breakpoints.watch_hit) {
+        breakpoints.watch_hit = false;
+        std::cout << "Watchpoint " << (breakpoints.watch_write ? "write" : "read") << " at $" << std::hex
+                  << breakpoints.watch_address << ": $" << (int)breakpoints.watch_value << std::endl;
+        do_break = true;
+    }
+}
 
-        case STY_ZP:
-            memory_write_byte_handler(machine, READ_ADDR_ZP(), Y);
-            break;
-        case STY_ZP_X:
-            memory_write_byte_handler(machine, READ_ADDR_ZP_X(), Y);
-            break;
-        case STY_ABS:
-            READ_ADDR_ABS();
-            memory_write_byte_handler(machine, addr, Y);
-            break;
 
-            // ADD to accumulator with carry
-        case ADC_IMM:
-            ADC(READ_BYTE_IMM());
-            break;
-        case ADC_ZP:
-            ADC(READ_BYTE_ZP());
-            break;
-        case ADC_ZP_X:
-            ADC(READ_BYTE_ZP_X());
-            break;
-        case ADC_ABS:
-            READ_BYTE_ABS(b1);
-            ADC(b1);
-            break;
-        case ADC_ABS_X:
-            READ_ADDR_ABS_X();
-            ADC(memory_read_byte_handler(machine, addr));
-            break;
-        case ADC_ABS_Y:
-            READ_ADDR_ABS_Y();
-            ADC(memory_read_byte_handler(machine, addr));
-            break;
-        case ADC_IND_X:
-            ADC(READ_BYTE_IND_X());
-            break;
-        case ADC_IND_Y:
-            addr = READ_ADDR_IND_Y();
-            ADC(memory_read_byte_handler(machine, addr));
-            break;
+template <typename Bus>
+template <bool Debug, bool BusTiming>
+bool MOS6502<Bus>::exec(bool& do_break)
+{
+    if (instruction_load && ! load_instruction<Debug>(do_break)) {
+        return false;
+    }
 
-            // Subtract from accumulator with borrow
-        case SBC_IMM:
-            SBC(READ_BYTE_IMM());
-            break;
-        case SBC_ZP:
-            SBC(READ_BYTE_ZP());
-            break;
-        case SBC_ZP_X:
-            SBC(READ_BYTE_ZP_X());
-            break;
-        case SBC_ABS:
-            READ_BYTE_ABS(b1);
-            SBC(b1);
-            break;
-        case SBC_ABS_X:
-            READ_ADDR_ABS_X();
-            SBC(memory_read_byte_handler(machine, addr));
-            break;
-        case SBC_ABS_Y:
-            READ_ADDR_ABS_Y();
-            SBC(memory_read_byte_handler(machine, addr));
-            break;
-        case SBC_IND_X:
-            SBC(READ_BYTE_IND_X());
-            break;
-        case SBC_IND_Y:
-            addr = READ_ADDR_IND_Y();
-            SBC(memory_read_byte_handler(machine, addr));
-            break;
+    if (++current_cycle < instruction_cycles) {
+        if (BusTiming) {
+            if (f_bus_cycle handler = bus_cycle_handlers[current_instruction]) {
+                handler(*this, instruction_cycles - current_cycle);
+            }
+        }
+        return false;
+    }
 
-            // Increment memory by one
-        case INC_ZP:
-            addr = READ_ADDR_ZP();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) + 1));
-            break;
-        case INC_ZP_X:
-            addr = READ_ADDR_ZP_X();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) + 1));
-            break;
-        case INC_ABS:
-            READ_ADDR_ABS();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) + 1));
-            break;
-        case INC_ABS_X:
-            READ_ADDR_ABS_X();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) + 1));
-            break;
+    execute_instruction<BusTiming>(do_break);
+    if (Debug) {
+        check_watch(do_break);
+    }
+    return true;
+}
 
-            // Decrease memory by one
-        case DEC_ZP:
-            addr = READ_ADDR_ZP();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) - 1));
-            break;
-        case DEC_ZP_X:
-            addr = READ_ADDR_ZP_X();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) - 1));
-            break;
-        case DEC_ABS:
-            READ_ADDR_ABS();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) - 1));
-            break;
-        case DEC_ABS_X:
-            READ_ADDR_ABS_X();
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(memory_read_byte_handler(machine, addr) - 1));
-            break;
 
-            // Increase X by one
-        case INX:
-            SET_FLAG_NZ(++X);
-            break;
-            // Decrease X by one
-        case DEX:
-            SET_FLAG_NZ(--X);
-            break;
-            // Increase Y by one
-        case INY:
-            SET_FLAG_NZ(++Y);
-            break;
-            // Decrease Y by one
-        case DEY:
-            SET_FLAG_NZ(--Y);
-            break;
+template <typename Bus>
+template <bool Debug>
+uint8_t MOS6502<Bus>::exec_instruction(bool& do_break)
+{
+    if (instruction_load && ! load_instruction<Debug>(do_break)) {
+        return 0;
+    }
 
-            // And accumulator with memory
-        case AND_IMM:
-            SET_FLAG_NZ(A &= READ_BYTE_IMM());
-            break;
-        case AND_ZP:
-            SET_FLAG_NZ(A &= READ_BYTE_ZP());
-            break;
-        case AND_ZP_X:
-            SET_FLAG_NZ(A &= READ_BYTE_ZP_X());
-            break;
-        case AND_ABS:
-            READ_BYTE_ABS(b1);
-            SET_FLAG_NZ(A &= b1);
-            break;
-        case AND_ABS_X:
-            READ_ADDR_ABS_X();
-            SET_FLAG_NZ(A &= memory_read_byte_handler(machine, addr));
-            break;
-        case AND_ABS_Y:
-            READ_ADDR_ABS_Y();
-            SET_FLAG_NZ(A &= memory_read_byte_handler(machine, addr));
-            break;
-        case AND_IND_X:
-            SET_FLAG_NZ(A &= READ_BYTE_IND_X());
-            break;
-        case AND_IND_Y :
-            addr = READ_ADDR_IND_Y();
-            SET_FLAG_NZ(A &= memory_read_byte_handler(machine, addr));
-            break;
+    // Cycles already spent by exec() count towards this instruction if modes were switched mid-instruction.
+    // The rest are left to get_cycles_ahead() while executing, for timing bus accesses.
+    uint8_t cycles = instruction_cycles - current_cycle;
+    cycles_ahead = cycles;
+    execute_instruction(do_break);
+    cycles_ahead = 0;
+    current_cycle = instruction_cycles;
+    if (Debug) {
+        check_watch(do_break);
+    }
+    return cycles;
+}
 
-            // Or accumulator with memory
-        case ORA_IMM:
-            SET_FLAG_NZ(A |= READ_BYTE_IMM());
-            break;
-        case ORA_ZP:
-            SET_FLAG_NZ(A |= READ_BYTE_ZP());
-            break;
-        case ORA_ZP_X:
-            SET_FLAG_NZ(A |= READ_BYTE_ZP_X());
-            break;
-        case ORA_ABS:
-            READ_BYTE_ABS(b1);
-            SET_FLAG_NZ(A |= b1);
-            break;
-        case ORA_ABS_X:
-            READ_ADDR_ABS_X();
-            SET_FLAG_NZ(A |= memory_read_byte_handler(machine, addr));
-            break;
-        case ORA_ABS_Y:
-            READ_ADDR_ABS_Y();
-            SET_FLAG_NZ(A |= memory_read_byte_handler(machine, addr));
-            break;
-        case ORA_IND_X:
-            SET_FLAG_NZ(A |= READ_BYTE_IND_X());
-            break;
-        case ORA_IND_Y:
-            addr = READ_ADDR_IND_Y();
-            SET_FLAG_NZ(A |= memory_read_byte_handler(machine, addr));
-            break;
 
-            // Exclusive or accumulator with memory
-        case EOR_IMM:
-            SET_FLAG_NZ(A ^= READ_BYTE_IMM());
-            break;
-        case EOR_ZP:
-            SET_FLAG_NZ(A ^= READ_BYTE_ZP());
-            break;
-        case EOR_ZP_X:
-            SET_FLAG_NZ(A ^= READ_BYTE_ZP_X());
-            break;
-        case EOR_ABS:
-            READ_BYTE_ABS(b1);
-            SET_FLAG_NZ(A ^= b1);
-            break;
-        case EOR_ABS_X:
-            READ_ADDR_ABS_X();
-            SET_FLAG_NZ(A ^= memory_read_byte_handler(machine, addr));
-            break;
-        case EOR_ABS_Y:
-            READ_ADDR_ABS_Y();
-            SET_FLAG_NZ(A ^= memory_read_byte_handler(machine, addr));
-            break;
-        case EOR_IND_X:
-            SET_FLAG_NZ(A ^= READ_BYTE_IND_X());
-            break;
-        case EOR_IND_Y:
-            addr = READ_ADDR_IND_Y();
-            SET_FLAG_NZ(A ^= memory_read_byte_handler(machine, addr));
-            break;
+template <typename Bus>
+template <bool BusTiming>
+void MOS6502<Bus>::execute_instruction(bool& do_break)
+{
+    instruction_load = true;
+    ++instruction_count;
 
-            //      +-+-+-+-+-+-+-+-+
-            // C <- |7|6|5|4|3|2|1|0| <- 0              N Z C I D V
-            //      +-+-+-+-+-+-+-+-+                   / / / _ _ _
-        case ASL_ACC:
-            C = A & 0x80;
-            SET_FLAG_NZ(A <<= 1);
-            break;
-        case ASL_ZP:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP());
-            C = b1 & 0x80;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(b1 <<= 1));
-            break;
-        case ASL_ZP_X:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP_X());
-            C = b1 & 0x80;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(b1 <<= 1));
-            break;
-        case ASL_ABS:
-            READ_ADDR_ABS();
-            b1 = memory_read_byte_handler(machine, addr);
-            C = b1 & 0x80;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(b1 <<= 1));
-            break;
-        case ASL_ABS_X:
-            READ_ADDR_ABS_X();
-            b1 = memory_read_byte_handler(machine, addr);
-            C = b1 & 0x80;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(b1 <<= 1));
-            break;
+    if (BusTiming) {
+        bus_timing_execute_table[current_instruction](*this, do_break);
+    }
+    else {
+        execute_table[current_instruction](*this, do_break);
+    }
+}
 
-            //      +-+-+-+-+-+-+-+-+
-            // 0 -> |7|6|5|4|3|2|1|0| -> C              N Z C I D V
-            //      +-+-+-+-+-+-+-+-+                   0 / / _ _ _
-        case LSR_ACC:
-            C = A & 0x01;
-            SET_FLAG_NZ(A >>= 1);
-            break;
-        case LSR_ZP:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP());
-            C = b1 & 0x01;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(b1 >>= 1));
-            break;
-        case LSR_ZP_X:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP_X());
-            C = b1 & 0x01;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(b1 >>= 1));
-            break;
-        case LSR_ABS:
-            READ_ADDR_ABS();
-            b1 = memory_read_byte_handler(machine, addr);
-            C = b1 & 0x01;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(b1 >>= 1));
-            break;
-        case LSR_ABS_X:
-            READ_ADDR_ABS_X();
-            b1 = memory_read_byte_handler(machine, addr);
-            C = b1 & 0x01;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(b1 >>= 1));
-            break;
 
-            // +------------------------------+
-            // |         M or A               |
-            // |   +-+-+-+-+-+-+-+-+    +-+   |
-            // +-< |7|6|5|4|3|2|1|0| <- |C| <-+         N Z C I D V
-            //     +-+-+-+-+-+-+-+-+    +-+             / / / _ _ _
-        case ROL_ACC:
-            b2 = A & 0x80;
-            SET_FLAG_NZ(A = C ? (A<<=1) + 1 : A<<=1);
-            C = b2;
-            break;
-        case ROL_ZP:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP());
-            b2 = b1 & 0x80;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(C ? (b1<<=1) + 1 : b1<<=1));
-            C = b2;
-            break;
-        case ROL_ZP_X:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP_X());
-            b2 = b1 & 0x80;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(C ? (b1<<=1) + 1 : b1<<=1));
-            C = b2;
-            break;
-        case ROL_ABS:
-            READ_ADDR_ABS();
-            b1 = memory_read_byte_handler(machine, addr);
-            b2 = b1 & 0x80;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(C ? (b1<<=1) + 1 : b1<<=1));
-            C = b2;
-            break;
-        case ROL_ABS_X:
-            READ_ADDR_ABS_X();
-            b1 = memory_read_byte_handler(machine, addr);
-            b2 = b1 & 0x80;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(C ? (b1<<=1) + 1 : b1<<=1));
-            C = b2;
-            break;
+template <typename Bus>
+template <bool BusTiming, size_t... Opcodes>
+constexpr std::array<typename MOS6502<Bus>::f_execute, 256> MOS6502<Bus>::make_execute_table(std::index_sequence<Opcodes...>)
+{
+    // Only read-modify-write instructions differ with bus timing.
+    return {&MOS6502<Bus>::execute_opcode<Opcodes, BusTiming && bus_cycle_table[Opcodes][2] == BusOp::read>...};
+}
 
-            // +------------------------------+
-            // |                              |
-            // |   +-+    +-+-+-+-+-+-+-+-+   |
-            // +-> |C| -> |7|6|5|4|3|2|1|0| >-+         N Z C I D V
-            //     +-+    +-+-+-+-+-+-+-+-+             / / / _ _ _
-        case ROR_ACC:
-            b2 = A & 0x01;
-            SET_FLAG_NZ(A = C ? (A>>=1)|0x80 : A>>=1);
-            C = b2;
-            break;
-        case ROR_ZP:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP());
-            b2 = b1 & 0x01;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(C ? (b1>>=1) | 0x80 : b1>>=1));
-            C = b2;
-            break;
-        case ROR_ZP_X:
-            b1 = memory_read_byte_zp_handler(machine, addr = READ_ADDR_ZP_X());
-            b2 = b1 & 0x01;
-            memory_write_byte_zp_handler(machine, addr, SET_FLAG_NZ(C ? (b1>>=1) | 0x80 : b1>>=1));
-            C = b2;
-            break;
-        case ROR_ABS:
-            READ_ADDR_ABS();
-            b1 = memory_read_byte_handler(machine, addr);
-            b2 = b1 & 0x01;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(C ? (b1>>=1) | 0x80 : b1>>=1));
-            C = b2;
-            break;
-        case ROR_ABS_X:
-            READ_ADDR_ABS_X();
-            b1 = memory_read_byte_handler(machine, addr);
-            b2 = b1 & 0x01;
-            memory_write_byte_handler(machine, addr, SET_FLAG_NZ(C ? (b1>>=1) | 0x80 : b1>>=1));
-            C = b2;
-            break;
+template <typename Bus>
+const std::array<typename MOS6502<Bus>::f_execute, 256> MOS6502<Bus>::execute_table =
+    make_execute_table<false>(std::make_index_sequence<256>());
 
-            // Branches
-        case BCC:
-            if (!C) {
-                PC = READ_JUMP_ADDR();
-            }
-            else
-                ++PC;
-            break;
-        case BCS:
-            if (C) {
-                PC = READ_JUMP_ADDR();
-            }
-            else
-                ++PC;
-            break;
-        case BEQ:
-            if (Z) {
-                PC = READ_JUMP_ADDR();
-            }
-            else
-                ++PC;
-            break;
-        case BNE:
-            if (!Z) {
-                PC = READ_JUMP_ADDR();
-            }
-            else
-                ++PC;
-            break;
+template <typename Bus>
+const std::array<typename MOS6502<Bus>::f_execute, 256> MOS6502<Bus>::bus_timing_execute_table =
+    make_execute_table<true>(std::make_index_sequence<256>());
 
-        case BMI:
-            if (N) {
-                PC = READ_JUMP_ADDR();
-            }
-            else
-                ++PC;
-            break;
 
-        case BPL:
-            if (!N) {
-                PC = READ_JUMP_ADDR();
+template <typename Bus>
+template <size_t... Opcodes>
+constexpr std::array<typename MOS6502<Bus>::f_bus_cycle, 256> MOS6502<Bus>::make_bus_cycle_handlers(std::index_sequence<Opcodes...>)
+{
+    return {(bus_cycle_table[Opcodes] == BusCycles{} ? nullptr : &MOS6502<Bus>::bus_cycle_opcode<Opcodes>)...};
+}
+
+template <typename Bus>
+const std::array<typename MOS6502<Bus>::f_bus_cycle, 256> MOS6502<Bus>::bus_cycle_handlers =
+    make_bus_cycle_handlers(std::make_index_sequence<256>());
+
+
+template <typename Bus>
+template <uint8_t Opcode>
+void MOS6502<Bus>::bus_cycle(uint8_t cycles_left)
+{
+    constexpr Addressing mode = opcode_table[Opcode].addressing;
+    constexpr BusCycles ops = bus_cycle_table[Opcode];
+    constexpr bool modifies = ops[2] == BusOp::read;
+
+    if (cycles_left >= ops.size()) {
+        return;
+    }
+
+    switch (ops[cycles_left]) {
+        case BusOp::page_cross_read:
+        case BusOp::dummy_read:
+            if constexpr (mode == Addressing::absolute_indexed_x || mode == Addressing::absolute_indexed_y ||
+                          mode == Addressing::indirect_indexed_y) {
+                // Low byte is indexed before the carry reaches the high byte.
+                uint16_t address = operand_address<mode>();
+                uint16_t base = mode == Addressing::indirect_indexed_y ? bus.read_word_zp(current_operand)
+                                                                       : current_operand;
+                uint16_t uncarried = (base & 0xff00) | (address & 0xff);
+                if (ops[cycles_left] == BusOp::dummy_read || uncarried != address) {
+                    bus.read_byte(uncarried);
+                }
             }
-            else
-                ++PC;
             break;
-        case BVC:
 
-            if (!V) {
-                PC = READ_JUMP_ADDR();
+        case BusOp::read:
+            if constexpr (modifies) {
+                data_latch = load<mode>(operand_address<mode>());
             }
-            else
-                ++PC;
             break;
 
-        case BVS:
-            if (V) {
-                PC = READ_JUMP_ADDR();
+        case BusOp::dummy_write:
+            if constexpr (modifies) {
+                store<mode>(operand_address<mode>(), data_latch);
             }
-            else
-                ++PC;
             break;
 
-        case BIT_ZP:
-            b1 = READ_BYTE_ZP();
-            N_INTERN = b1;
-            Z_INTERN = A & b1;
-            V = b1 & FLAG_V;  // bit 6 -> V
+        case BusOp::none:
             break;
+    }
+}
 
-        case BIT_ABS:
-            READ_BYTE_ABS(b1);
-            N_INTERN = b1;
-            Z_INTERN = A & b1;
-            V = b1 & FLAG_V;  // bit 6 -> V
-            break;
 
-        case SEC: // Set carry flag
-            C = true;
-            break;
-        case SED: // Set decimal flag
-            D = true;
-            break;
-        case SEI: // Set interrupt flag
-            I = true;
-            break;
+template <typename Bus>
+template <Addressing Mode>
+uint16_t MOS6502<Bus>::operand_address()
+{
+    if constexpr (Mode == Addressing::zero_page) {
+        return (uint8_t)current_operand;
+    }
+    else if constexpr (Mode == Addressing::zero_page_indexed_x) {
+        return (uint8_t)(current_operand + X);
+    }
+    else if constexpr (Mode == Addressing::zero_page_indexed_y) {
+        return (uint8_t)(current_operand + Y);
+    }
+    else if constexpr (Mode == Addressing::absolute_indexed_x) {
+        return current_operand + X;
+    }
+    else if constexpr (Mode == Addressing::absolute_indexed_y) {
+        return current_operand + Y;
+    }
+    else if constexpr (Mode == Addressing::indexed_indirect_x) {
+        return bus.read_word_zp(current_operand + X);
+    }
+    else if constexpr (Mode == Addressing::indirect_indexed_y) {
+        return bus.read_word_zp(current_operand) + Y;
+    }
+    else {
+        static_assert(Mode == Addressing::absolute || Mode == Addressing::indirect_absolute,
+                      "addressing mode has no operand address");
+        return current_operand;
+    }
+}
 
-        case CLC: // Clear carry flag
-            C = false;
-            break;
-        case CLD: // Clear decimal flag
-            D = false;
-            break;
-        case CLI: // Clear interrupt flag
-            I = false;
-            break;
-        case CLV: // Clear overflow flag
-            V = false;
-            break;
+template <typename Bus>
+template <Addressing Mode>
+uint8_t MOS6502<Bus>::load(uint16_t address)
+{
+    if constexpr (is_zero_page(Mode)) {
+        return bus.read_byte_zp(address);
+    }
+    else {
+        return bus.read_byte(address);
+    }
+}
 
-        case CMP_IMM:
-            i = A - READ_BYTE_IMM();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_ZP:
-            i = A - READ_BYTE_ZP();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_ZP_X:
-            i = A - READ_BYTE_ZP_X();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_ABS:
-            READ_BYTE_ABS(b1);
-            i = A - b1;
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_ABS_X:
-            READ_ADDR_ABS_X();
-            i = A - memory_read_byte_handler(machine, addr);
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_ABS_Y:
-            READ_ADDR_ABS_Y();
-            i = A - memory_read_byte_handler(machine, addr);
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_IND_X:
-            i = A - READ_BYTE_IND_X();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CMP_IND_Y:
-            addr = READ_ADDR_IND_Y();
-            i = A - memory_read_byte_handler(machine, addr);
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
+template <typename Bus>
+template <Addressing Mode>
+void MOS6502<Bus>::store(uint16_t address, uint8_t value)
+{
+    if constexpr (is_zero_page(Mode)) {
+        bus.write_byte_zp(address, value);
+    }
+    else {
+        bus.write_byte(address, value);
+    }
+}
 
-        case CPX_IMM:
-            i = X - READ_BYTE_IMM();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CPX_ZP:
-            i = X - READ_BYTE_ZP();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CPX_ABS:
-            READ_BYTE_ABS(b1);
-            i = X - b1;
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
+template <typename Bus>
+template <Addressing Mode>
+uint8_t MOS6502<Bus>::read_operand()
+{
+    if constexpr (Mode == Addressing::immediate) {
+        return current_operand;
+    }
+    else {
+        return load<Mode>(operand_address<Mode>());
+    }
+}
 
-        case CPY_IMM:
-            i = Y - READ_BYTE_IMM();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CPY_ZP:
-            i = Y - READ_BYTE_ZP();
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
-        case CPY_ABS:
-            READ_BYTE_ABS(b1);
-            i = Y - b1;
-            C = i >= 0;
-            SET_FLAG_NZ((uint8_t)i);
-            break;
+template <typename Bus>
+template <Addressing Mode, bool BusTiming, typename Modify>
+void MOS6502<Bus>::modify_operand(Modify modify)
+{
+    if constexpr (Mode == Addressing::accumulator) {
+        A = modify(A);
+    }
+    else {
+        uint16_t address = operand_address<Mode>();
+        store<Mode>(address, modify(BusTiming ? data_latch : load<Mode>(address)));
+    }
+}
 
-        case JMP_ABS:
-            READ_ADDR_ABS();
-            PC = addr;
-            break;
-        case JMP_IND:
-            READ_ADDR_ABS();
-            PC = memory_read_word_handler(machine, addr);
-            break;
+template <typename Bus>
+void MOS6502<Bus>::compare(uint8_t reg, uint8_t value)
+{
+    flags.c = 0x100 + reg - value;
+    SET_FLAG_NZ((uint8_t)flags.c);
+}
 
-        case JSR:
-            PUSH_BYTE_STACK((PC+1) >> 8); // Store 1 before next instruction
-            PUSH_BYTE_STACK((PC+1) & 0xff);
-            READ_ADDR_ABS();
-            PC = addr;
-            break;
+template <typename Bus>
+void MOS6502<Bus>::branch(bool taken)
+{
+    if (taken) {
+        PC += (int8_t)current_operand;
+    }
+}
 
-        case RTS:
-            PC = POP_BYTE_STACK();
-            PC += (POP_BYTE_STACK() << 8) + 1;
-            break;
 
-        case BRK:
-            PUSH_BYTE_STACK((PC+1) >> 8); // Byte after BRK will not be executed on return!
-            PUSH_BYTE_STACK(PC+1);
-            PUSH_BYTE_STACK(get_p() | FLAG_B);
-            I = true;
-            D = false;
-            PC = memory_read_word_handler(machine, IRQ_VECTOR_L);
-            break;
+template <typename Bus>
+template <uint8_t Opcode, bool BusTiming>
+void MOS6502<Bus>::execute(bool& do_break)
+{
+    constexpr Operation operation = opcode_table[Opcode].operation;
+    constexpr Addressing mode = opcode_table[Opcode].addressing;
 
-        case RTI:  // Return from interrupt
-            set_p(POP_BYTE_STACK()); //  & 0xdb);
-            PC = POP_BYTE_STACK();
-            PC += (POP_BYTE_STACK() << 8);
-            break;
+    // PC is at next instruction while executing, operands are read when decoding.
+    PC += opcode_table[Opcode].length;
 
-        case NOP:
-            break;
+    // Load and store
+    if constexpr (operation == Operation::lda) {
+        SET_FLAG_NZ(A = read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::ldx) {
+        SET_FLAG_NZ(X = read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::ldy) {
+        SET_FLAG_NZ(Y = read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::sta) {
+        store<mode>(operand_address<mode>(), A);
+    }
+    else if constexpr (operation == Operation::stx) {
+        store<mode>(operand_address<mode>(), X);
+    }
+    else if constexpr (operation == Operation::sty) {
+        store<mode>(operand_address<mode>(), Y);
+    }
 
-        case PHA:  // Push accumulator to stack
-            PUSH_BYTE_STACK(A);
-            break;
-        case PLA:  // Pull accumulator from stack
-            A = POP_BYTE_STACK();
-            SET_FLAG_NZ(A);
-            break;
-        case PHP:  // Push status to stack
-            PUSH_BYTE_STACK(get_p());
-            break;
-        case PLP:  // Pull status from stack
-            set_p(POP_BYTE_STACK());
-            break;
+    // Arithmetic and logic
+    else if constexpr (operation == Operation::adc) {
+        ADC(read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::sbc) {
+        SBC(read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::and_) {
+        SET_FLAG_NZ(A &= read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::ora) {
+        SET_FLAG_NZ(A |= read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::eor) {
+        SET_FLAG_NZ(A ^= read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::cmp) {
+        compare(A, read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::cpx) {
+        compare(X, read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::cpy) {
+        compare(Y, read_operand<mode>());
+    }
+    else if constexpr (operation == Operation::bit) {
+        uint8_t value = read_operand<mode>();
+        flags.n = value;
+        flags.z = A & value;
+        flags.v = value;  // bit 6 -> V
+    }
 
-        case TAX:  // Transfer A to X
-            SET_FLAG_NZ(X = A);
-            break;
-        case TXA:  // Transfer X to A
-            SET_FLAG_NZ(A = X);
-            break;
-        case TAY:  // Transfer A to Y
-            SET_FLAG_NZ(Y = A);
-            break;
-        case TYA:  // Transfer Y to A
-            SET_FLAG_NZ(A = Y);
-            break;
-        case TXS:  // Transfer X to SP
-            SET_FLAG_NZ(SP = X);
-            break;
-        case TSX:  // Transfer SP to X
-            SET_FLAG_NZ(X = SP);
-            break;
+    // Increment and decrement
+    else if constexpr (operation == Operation::inc) {
+        modify_operand<mode, BusTiming>([this](uint8_t value) { return SET_FLAG_NZ(value + 1); });
+    }
+    else if constexpr (operation == Operation::dec) {
+        modify_operand<mode, BusTiming>([this](uint8_t value) { return SET_FLAG_NZ(value - 1); });
+    }
+    else if constexpr (operation == Operation::inx) {
+        SET_FLAG_NZ(++X);
+    }
+    else if constexpr (operation == Operation::dex) {
+        SET_FLAG_NZ(--X);
+    }
+    else if constexpr (operation == Operation::iny) {
+        SET_FLAG_NZ(++Y);
+    }
+    else if constexpr (operation == Operation::dey) {
+        SET_FLAG_NZ(--Y);
+    }
 
-//        case ILL_SBX:
-//            i = (A & X) - READ_BYTE_IMM();
-//            SET_FLAG_NZ(i);
-//            C = i >= 0;
-//            X = i;
-//            break;
-
-        case ILL_SLO_IND_X:
-            b1 = memory_read_byte_handler(machine, addr = READ_ADDR_IND_X());
-            C = (b1 & 0x80) != 0;
-            b1 <<= 1;
-            memory_write_byte_handler(machine, addr, b1);
-            SET_FLAG_NZ(A |= b1);
-            break;
+    //      +-+-+-+-+-+-+-+-+
+    // C <- |7|6|5|4|3|2|1|0| <- 0              N Z C I D V
+    //      +-+-+-+-+-+-+-+-+                   / / / _ _ _
+    else if constexpr (operation == Operation::asl) {
+        modify_operand<mode, BusTiming>([this](uint8_t value) {
+            flags.c = value << 1;
+            return SET_FLAG_NZ(value << 1);
+        });
+    }
 
-        case ILL_SLO_IND_Y:
-            b1 = memory_read_byte_handler(machine, addr = READ_ADDR_IND_Y());
-            C = (b1 & 0x80) != 0;
-            b1 <<= 1;
-            memory_write_byte_handler(machine, addr, b1);
-            SET_FLAG_NZ(A |= b1);
-            break;
+    //      +-+-+-+-+-+-+-+-+
+    // 0 -> |7|6|5|4|3|2|1|0| -> C              N Z C I D V
+    //      +-+-+-+-+-+-+-+-+                   0 / / _ _ _
+    else if constexpr (operation == Operation::lsr) {
+        modify_operand<mode, BusTiming>([this](uint8_t value) {
+            flags.c = value << 8;
+            return SET_FLAG_NZ(value >> 1);
+        });
+    }
 
-        case ILL_RLA_IND_Y:
-            b1 = memory_read_byte_handler(machine, addr = READ_ADDR_IND_Y());
-            b2 = b1 & 0x80;
-            b1 <<= 1;
-            if (C) { b1 |= 0x01; }
-            memory_write_byte_handler(machine, addr, b1);
-            C = b2 != 0;
-            SET_FLAG_NZ(A &= b1);
-            break;
+    // +------------------------------+
+    // |         M or A               |
+    // |   +-+-+-+-+-+-+-+-+    +-+   |
+    // +-< |7|6|5|4|3|2|1|0| <- |C| <-+         N Z C I D V
+    //     +-+-+-+-+-+-+-+-+    +-+             / / / _ _ _
+    else if constexpr (operation == Operation::rol) {
+        modify_operand<mode, BusTiming>([this](uint8_t value) {
+            flags.c = value << 1 | C;
+            return SET_FLAG_NZ(flags.c);
+        });
+    }
 
-        case ILL_NOP_IMP_1A:
-        case ILL_NOP_IMP_3A:
-        case ILL_NOP_IMP_5A:
-        case ILL_NOP_IMP_7A:
-        case ILL_NOP_IMP_DA:
-        case ILL_NOP_IMP_FA:
-            break;
+    // +------------------------------+
+    // |                              |
+    // |   +-+    +-+-+-+-+-+-+-+-+   |
+    // +-> |C| -> |7|6|5|4|3|2|1|0| >-+         N Z C I D V
+    //     +-+    +-+-+-+-+-+-+-+-+             / / / _ _ _
+    else if constexpr (operation == Operation::ror) {
+        modify_operand<mode, BusTiming>([this](uint8_t value) {
+            uint8_t result = (value >> 1) | C << 7;
+            flags.c = value << 8;
+            return SET_FLAG_NZ(result);
+        });
+    }
 
-        case ILL_NOP_IMM_80:
-        case ILL_NOP_IMM_82:
-        case ILL_NOP_IMM_89:
-        case ILL_NOP_IMM_C2:
-        case ILL_NOP_IMM_E2:
-            i = READ_BYTE_IMM();
-            break;
+    // Branches
+    else if constexpr (operation == Operation::bcc) {
+        branch(!C);
+    }
+    else if constexpr (operation == Operation::bcs) {
+        branch(C);
+    }
+    else if constexpr (operation == Operation::beq) {
+        branch(Z);
+    }
+    else if constexpr (operation == Operation::bne) {
+        branch(!Z);
+    }
+    else if constexpr (operation == Operation::bmi) {
+        branch(N);
+    }
+    else if constexpr (operation == Operation::bpl) {
+        branch(!N);
+    }
+    else if constexpr (operation == Operation::bvc) {
+        branch(!V);
+    }
+    else if constexpr (operation == Operation::bvs) {
+        branch(V);
+    }
 
-        case ILL_NOP_ZP_04:
-        case ILL_NOP_ZP_44:
-        case ILL_NOP_ZP_64:
-            addr = READ_ADDR_ZP();
-            break;
+    // Jumps and interrupts
+    else if constexpr (operation == Operation::jmp) {
+        PC = mode == Addressing::absolute ? current_operand : bus.read_word(current_operand);
+    }
+    else if constexpr (operation == Operation::jsr) {
+        PUSH_BYTE_STACK((PC-1) >> 8); // Store 1 before next instruction
+        PUSH_BYTE_STACK((PC-1) & 0xff);
+        PC = current_operand;
+    }
+    else if constexpr (operation == Operation::rts) {
+        PC = POP_BYTE_STACK();
+        PC += (POP_BYTE_STACK() << 8) + 1;
+    }
+    else if constexpr (operation == Operation::brk) {
+        PUSH_BYTE_STACK((PC+1) >> 8); // Byte after BRK will not be executed on return!
+        PUSH_BYTE_STACK(PC+1);
+        PUSH_BYTE_STACK(get_p() | FLAG_B);
+        flags.p = (flags.p | FLAG_I) & ~FLAG_D;
+        PC = bus.read_word(IRQ_VECTOR_L);
+    }
+    else if constexpr (operation == Operation::rti) {
+        set_p(POP_BYTE_STACK());
+        PC = POP_BYTE_STACK();
+        PC += (POP_BYTE_STACK() << 8);
+    }
 
-        case ILL_NOP_ZPX_14:
-        case ILL_NOP_ZPX_34:
-        case ILL_NOP_ZPX_54:
-        case ILL_NOP_ZPX_74:
-        case ILL_NOP_ZPX_D4:
-        case ILL_NOP_ZPX_F4:
-            addr = READ_ADDR_ZP_X();
-            break;
+    // Flags
+    else if constexpr (operation == Operation::sec) {
+        flags.c = 0x100;
+    }
+    else if constexpr (operation == Operation::sed) {
+        flags.p |= FLAG_D;
+    }
+    else if constexpr (operation == Operation::sei) {
+        flags.p |= FLAG_I;
+    }
+    else if constexpr (operation == Operation::clc) {
+        flags.c = 0;
+    }
+    else if constexpr (operation == Operation::cld) {
+        flags.p &= ~FLAG_D;
+    }
+    else if constexpr (operation == Operation::cli) {
+        flags.p &= ~FLAG_I;
+    }
+    else if constexpr (operation == Operation::clv) {
+        flags.v = 0;
+    }
 
-        case ILL_NOP_ABS_0C:
-            addr = READ_ADDR_ABS();
-            break;
+    // Stack and transfers
+    else if constexpr (operation == Operation::pha) {
+        PUSH_BYTE_STACK(A);
+    }
+    else if constexpr (operation == Operation::pla) {
+        SET_FLAG_NZ(A = POP_BYTE_STACK());
+    }
+    else if constexpr (operation == Operation::php) {
+        PUSH_BYTE_STACK(get_p());
+    }
+    else if constexpr (operation == Operation::plp) {
+        set_p(POP_BYTE_STACK());
+    }
+    else if constexpr (operation == Operation::tax) {
+        SET_FLAG_NZ(X = A);
+    }
+    else if constexpr (operation == Operation::txa) {
+        SET_FLAG_NZ(A = X);
+    }
+    else if constexpr (operation == Operation::tay) {
+        SET_FLAG_NZ(Y = A);
+    }
+    else if constexpr (operation == Operation::tya) {
+        SET_FLAG_NZ(A = Y);
+    }
+    else if constexpr (operation == Operation::txs) {
+        SET_FLAG_NZ(SP = X);
+    }
+    else if constexpr (operation == Operation::tsx) {
+        SET_FLAG_NZ(X = SP);
+    }
 
-        case ILL_NOP_ABS_X_1C:
-        case ILL_NOP_ABS_X_3C:
-        case ILL_NOP_ABS_X_5C:
-        case ILL_NOP_ABS_X_7C:
-        case ILL_NOP_ABS_X_DC:
-        case ILL_NOP_ABS_X_FC:
-            addr = READ_ADDR_ABS_X();
-            break;
+    // No operation, illegal NOPs do not read their operand.
+    else if constexpr (operation == Operation::nop) {
+    }
 
-        default:
+    // Illegal
+    else if constexpr (operation == Operation::slo) {
+        uint16_t address = operand_address<mode>();
+        uint8_t value = BusTiming ? data_latch : load<mode>(address);
+        flags.c = value << 1;
+        store<mode>(address, value <<= 1);
+        SET_FLAG_NZ(A |= value);
+    }
+    else if constexpr (operation == Operation::rla) {
+        uint16_t address = operand_address<mode>();
+        uint8_t value = BusTiming ? data_latch : load<mode>(address);
+        flags.c = value << 1 | C;
+        store<mode>(address, value = flags.c);
+        SET_FLAG_NZ(A &= value);
+    }
+
+    else if constexpr (operation == Operation::hle_trap) {
+        if (trap_handler && traps[PC - 1] && bus.read_byte(PC - 1) != HLE_TRAP) {
+            if (! trap_handler(bus, PC - 1)) {
+                // Not handled, execute the instruction the trap replaced.
+                --PC;
+                --instruction_count;
+                current_instruction = bus.read_byte(PC);
+                execute_instruction(do_break);
+            }
+        }
+        else {
             std::cout << "Unhandled illegal opcode: $" << std::hex << (int)current_instruction << std::endl << std::endl;
-//            PrintStat(pc_initial);
             do_break = true;
-            break;
-    };
-
-    if (! quiet) {
-        PrintStat(pc_initial);
+        }
+    }
+    else {
+        static_assert(operation == Operation::unknown, "operation not implemented");
+        std::cout << "Unhandled illegal opcode: $" << std::hex << (int)current_instruction << std::endl << std::endl;
+        do_break = true;
     }
-
-    return true;
 }
+
+
+template class MOS6502<OricBus>;
+template class MOS6502<FlatBus>;
+template class MOS6502<TracingBus>;
+
+#define INSTANTIATE_EXEC(Bus, Debug) \
+    template bool MOS6502<Bus>::exec<Debug, false>(bool& do_break); \
+    template bool MOS6502<Bus>::exec<Debug, true>(bool& do_break); \
+    template uint8_t MOS6502<Bus>::exec_instruction<Debug>(bool& do_break);
+
+INSTANTIATE_EXEC(OricBus, false)
+INSTANTIATE_EXEC(OricBus, true)
+INSTANTIATE_EXEC(FlatBus, false)
+INSTANTIATE_EXEC(FlatBus, true)
+INSTANTIATE_EXEC(TracingBus, false)
+INSTANTIATE_EXEC(TracingBus, true)
@@ -28,11 +28,18 @@
 #define MOS6502_H
 
 #include "mos6502_opcodes.hpp"
+#include "mos6502_opcode_table.hpp"
+#include "mos6502_alu.hpp"
+#include "breakpoints.hpp"
 #include "monitor.hpp"
+#include "profiler.hpp"
 #include "snapshot.hpp"
+#include "trace.hpp"
 
+#include <array>
 #include <memory>
-#include <set>
+#include <utility>
+#include <vector>
 
 
 #define STACK_BOTTOM 0x0100
@@ -46,24 +53,51 @@
 #define IRQ_VECTOR_L 0xFFFE
 #define IRQ_VECTOR_H 0xFFFF
 
-class Machine;
-class MOS6502;
 class Memory;
 
-typedef uint8_t (*f_memory_read_byte_handler)(Machine &oric, uint16_t address);
-typedef uint8_t (*f_memory_read_byte_zp_handler)(Machine &oric, uint8_t address);
-
-typedef uint16_t (*f_memory_read_word_handler)(Machine &oric, uint16_t address);
-typedef uint16_t (*f_memory_read_word_zp_handler)(Machine &oric, uint8_t address);
-
-typedef void (*f_memory_write_byte_handler)(Machine &oric, uint16_t address, uint8_t val);
-typedef void (*f_memory_write_byte_zp_handler)(Machine &oric, uint8_t address, uint8_t val);
-
 
+/**
+ * MOS 6502 CPU. All memory accesses go through the bus given as template parameter,
+ * so they can be inlined into the instruction implementations. A bus provides:
+ *
+ *   uint8_t read_byte(uint16_t address);
+ *   uint8_t read_byte_zp(uint8_t address);
+ *   uint16_t read_word(uint16_t address);
+ *   uint16_t read_word_zp(uint8_t address);
+ *   void write_byte(uint16_t address, uint8_t val);
+ *   void write_byte_zp(uint8_t address, uint8_t val);
+ *   Memory& memory;  // used directly for stack and monitor
+ *
+ * Supported buses are instantiated in mos6502.cpp.
+ */
+template <typename Bus>
 class MOS6502
 {
 public:
-    MOS6502(Machine& a_Machine);
+    /**
+     * Register values between instructions.
+     */
+    struct Registers
+    {
+        uint16_t pc;
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t p;
+        uint8_t sp;
+
+        bool operator==(const Registers& other) const = default;
+    };
+
+    /**
+     * Handler for trapped addresses.
+     * @param bus bus of the CPU
+     * @param address trapped address
+     * @return false to execute the instruction at address as usual
+     */
+    typedef bool (*f_trap_handler)(Bus& bus, uint16_t address);
+
+    MOS6502(const Bus& a_bus);
     ~MOS6502() = default;
 
     /**
@@ -103,10 +137,53 @@ public:
     void set_p(uint8_t p);
 
     /**
-     * Set quiet status.
-     * @param val new quiet value
+     * Get one flag of the P register.
+     * @param flag flag mask, like FLAG_C
+     * @return true if flag is set
+     */
+    bool get_flag(uint8_t flag) { return get_p() & flag; }
+
+    /**
+     * Set or clear one flag of the P register.
+     * @param flag flag mask, like FLAG_C
+     * @param value true to set flag
+     */
+    void set_flag(uint8_t flag, bool value) { set_p(value ? get_p() | flag : get_p() & ~flag); }
+
+    /**
+     * Get all registers.
+     * @return current register values
+     */
+    Registers get_registers() { return {PC, A, X, Y, get_p(), SP}; }
+
+    /**
+     * Set all registers.
+     * @param registers new register values
+     */
+    void set_registers(const Registers& registers);
+
+    /**
+     * Check if the instruction at PC has no effect outside the registers. Such an
+     * instruction only reads mapped RAM or ROM, apart from JSR pushing its return
+     * address. A loop of these instructions that gets back to the same registers
+     * will repeat until interrupted.
+     * @return true if instruction at PC is free of side effects
      */
-    void set_quiet(bool val) { quiet = val; }
+    bool is_idle_instruction();
+
+    /**
+     * Check if an interrupt will be entered before the next instruction.
+     * @return true if NMI or unmasked IRQ is pending
+     */
+    bool is_interrupt_pending() { return nmi_flag || (irq_flag && ! (flags.p & FLAG_I)); }
+
+    /**
+     * Get cycles of the executing instruction not yet run by the caller. Only non-zero while
+     * exec_instruction() executes a whole instruction. exec() runs each bus access on its own
+     * cycle, so it is always zero there, also for bus cycles before the last one.
+     * @return cycles left of instruction executed whole
+     */
+    uint8_t get_cycles_ahead() { return cycles_ahead; }
 
     /**
      * Reset the processor.
@@ -119,18 +196,44 @@ public:
     void PrintStat();
 
     /**
-     * Calculate CPU cycles used by instruction at PC.
+     * Decode instruction at PC and calculate CPU cycles used by it.
      * @return cycles used by instruction at PC
      */
     uint8_t time_instruction();
 
     /**
      * Execute instruction *cycle*.
+     * @tparam Debug true to check breakpoints and watchpoints and record trace and profile
+     * @tparam BusTiming true to do memory accesses on the cycles the 6502 does them, see
+     *         bus_cycle_table, false to do all on the last cycle of the instruction
      * @param do_break reference to varianble set to true if break is triggered
      * @return true if instruction was executed (not all cycles execute full instruction)
      */
+    template <bool Debug = false, bool BusTiming = false>
     bool exec(bool& do_break);
 
+    /**
+     * Execute one full instruction, including any pending interrupt.
+     * @tparam Debug true to check breakpoints and watchpoints and record trace and profile
+     * @param do_break reference to variable set to true if break is triggered
+     * @return number of cycles used by the instruction (0 if stopped at breakpoint)
+     */
+    template <bool Debug = false>
+    uint8_t exec_instruction(bool& do_break);
+
+    /**
+     * Set handler called instead of executing instructions at trapped addresses.
+     * @param handler trap handler, or nullptr to execute all instructions
+     */
+    void set_trap_handler(f_trap_handler handler);
+
+    /**
+     * Set or clear trap at address. Traps are only taken while a trap handler is set.
+     * @param address address of instruction to trap
+     * @param trap true to set trap, false to clear it
+     */
+    void set_trap(uint16_t address, bool trap);
+
     /**
      * Save CPU state to snapshot.
      * @param snapshot reference to snapshot
@@ -143,29 +246,24 @@ public:
      */
     void load_from_snapshot(Snapshot& snapshot);
 
-    void set_breakpoint(uint16_t address);
-
     // The public exposure of variables like below is uncommon for normal projects,
     // but this is an emulator where the chips must be able to quickly access each
     // other without the overhead of getter functions, etc.
 
+    // Number of instructions executed since reset.
+    uint64_t instruction_count;
+
     // Registers
     uint8_t A;
     uint8_t X;
     uint8_t Y;
 
-    // Flags
+    // Flags, see get_p() and get_flag() for the status register.
     //   7                           0
     // +---+---+---+---+---+---+---+---+
     // | N | V |   | B | D | I | Z | C |  <-- flag, 0/1 = reset/set
     // +---+---+---+---+---+---+---+---+
-    uint8_t N_INTERN; // negative
-    uint8_t Z_INTERN; // zero
-    bool V; // overflow
-    bool B; // break
-    bool D; // decimal
-    bool I; // interrupt
-    bool C; // carry
+    LazyFlags flags;
 
     /**
      * Trigger NMI (Non Maskable Interrupt).
@@ -174,22 +272,199 @@ public:
     void irq() { irq_flag = true; }
     void irq_clear() { irq_flag = false; }
 
-    f_memory_read_byte_handler memory_read_byte_handler;
-    f_memory_read_byte_zp_handler memory_read_byte_zp_handler;
+    /**
+     * Get bus used for memory accesses.
+     * @return reference to bus
+     */
+    Bus& get_bus() { return bus; }
 
-    f_memory_read_word_handler memory_read_word_handler;
-    f_memory_read_word_zp_handler memory_read_word_zp_handler;
+    /**
+     * Check if the Debug versions of exec() and exec_instruction() are needed.
+     * @return true if there are breakpoints or trace or profile is recorded
+     */
+    bool is_debugging() { return ! breakpoints.empty() || trace || profiler; }
 
-    f_memory_write_byte_handler memory_write_byte_handler;
-    f_memory_write_byte_zp_handler memory_write_byte_zp_handler;
+    // Only used by the Debug versions of exec() and exec_instruction().
+    Breakpoints breakpoints;
+    Trace* trace;           // nullptr when not tracing.
+    Profiler* profiler;     // nullptr when not profiling.
 
 protected:
+    typedef void (*f_execute)(MOS6502& cpu, bool& do_break);
+    typedef void (*f_bus_cycle)(MOS6502& cpu, uint8_t cycles_left);
+
+    struct DecodedInstruction
+    {
+        uint32_t generation;    // Memory page generation when decoded, 0 if not cached.
+        uint16_t operand;       // Operand bytes, little endian.
+        uint8_t opcode;
+        uint8_t cycles;         // Cycles without page crossings or taken branch.
+        Timing timing;
+        uint8_t branch_cycles;  // Extra cycles for taken branch, depends on target page.
+    };
+
+    /**
+     * Decode instruction at given address. Instructions in read only pages are
+     * cached until the page is remapped, other instructions are decoded every time.
+     * @param pc address of instruction
+     * @return decoded instruction
+     */
+    const DecodedInstruction& decode(uint16_t pc);
+
     /**
      * Print status and instruction at given address.
      * @param address
      */
     void PrintStat(uint16_t address);
 
+    /**
+     * Prepare instruction at PC: time it and enter any pending interrupt.
+     * @tparam Debug true to check breakpoints and record trace and profile
+     * @param do_break reference to variable set to true if break is triggered
+     * @return false if a breakpoint was hit
+     */
+    template <bool Debug>
+    bool load_instruction(bool& do_break);
+
+    /**
+     * Execute the loaded instruction.
+     * @tparam BusTiming true if bus_cycle() has done the accesses before the last cycle
+     * @param do_break reference to variable set to true if break is triggered
+     */
+    template <bool BusTiming = false>
+    void execute_instruction(bool& do_break);
+
+    /**
+     * Execute an opcode, as described by its entry in opcode_table.
+     * @tparam Opcode opcode to execute
+     * @tparam BusTiming true if bus_cycle() has read the value to modify into data_latch
+     * @param do_break reference to variable set to true if break is triggered
+     */
+    template <uint8_t Opcode, bool BusTiming>
+    void execute(bool& do_break);
+
+    /**
+     * Entry in execute tables, calling execute() for an opcode.
+     * @tparam Opcode opcode to execute
+     * @tparam BusTiming true if bus_cycle() has read the value to modify into data_latch
+     * @param cpu CPU to execute in
+     * @param do_break reference to variable set to true if break is triggered
+     */
+    template <uint8_t Opcode, bool BusTiming>
+    static void execute_opcode(MOS6502& cpu, bool& do_break) { cpu.execute<Opcode, BusTiming>(do_break); }
+
+    /**
+     * Generate table of execute_opcode() for all opcodes.
+     * @tparam BusTiming true for table used with bus_cycle()
+     * @return table indexed by opcode
+     */
+    template <bool BusTiming, size_t... Opcodes>
+    static constexpr std::array<f_execute, 256> make_execute_table(std::index_sequence<Opcodes...>);
+
+    /**
+     * Do the bus operation of an instruction cycle before the last, from bus_cycle_table.
+     * @tparam Opcode opcode being executed
+     * @param cycles_left cycles left of instruction
+     */
+    template <uint8_t Opcode>
+    void bus_cycle(uint8_t cycles_left);
+
+    /**
+     * Entry in bus_cycle_handlers, calling bus_cycle() for an opcode.
+     * @tparam Opcode opcode being executed
+     * @param cpu CPU to execute in
+     * @param cycles_left cycles left of instruction
+     */
+    template <uint8_t Opcode>
+    static void bus_cycle_opcode(MOS6502& cpu, uint8_t cycles_left) { cpu.bus_cycle<Opcode>(cycles_left); }
+
+    /**
+     * Generate table of bus_cycle_opcode(), nullptr for opcodes without bus operations.
+     * @return table indexed by opcode
+     */
+    template <size_t... Opcodes>
+    static constexpr std::array<f_bus_cycle, 256> make_bus_cycle_handlers(std::index_sequence<Opcodes...>);
+
+    /**
+     * Get address of operand, reading pointers for indirect addressing.
+     * @tparam Mode addressing mode
+     * @return operand address
+     */
+    template <Addressing Mode>
+    uint16_t operand_address();
+
+    /**
+     * Read byte for an addressing mode, using zero page access for zero page modes.
+     * @tparam Mode addressing mode
+     * @param address address to read
+     * @return read byte
+     */
+    template <Addressing Mode>
+    uint8_t load(uint16_t address);
+
+    /**
+     * Write byte for an addressing mode, using zero page access for zero page modes.
+     * @tparam Mode addressing mode
+     * @param address address to write
+     * @param value byte to write
+     */
+    template <Addressing Mode>
+    void store(uint16_t address, uint8_t value);
+
+    /**
+     * Read operand value of instruction.
+     * @tparam Mode addressing mode
+     * @return immediate value or value at operand address
+     */
+    template <Addressing Mode>
+    uint8_t read_operand();
+
+    /**
+     * Replace A or value at operand address with modified value.
+     * @tparam Mode addressing mode, accumulator or memory
+     * @tparam BusTiming true to modify data_latch instead of reading memory
+     * @param modify function returning modified value
+     */
+    template <Addressing Mode, bool BusTiming, typename Modify>
+    void modify_operand(Modify modify);
+
+    /**
+     * Implementation of CMP, CPX and CPY.
+     * @param reg register value
+     * @param value value to compare with
+     */
+    void compare(uint8_t reg, uint8_t value);
+
+    /**
+     * Implementation of branch instructions, relative to next instruction.
+     * @param taken true if branch condition is met
+     */
+    void branch(bool taken);
+
+    /**
+     * Check if breakpoint at PC should break, based on its condition.
+     * @return true if breakpoint condition is met
+     */
+    bool breakpoint_condition_met();
+
+    /**
+     * Break if a watchpoint was triggered by the last instruction.
+     * @param do_break reference to variable set to true if watchpoint was triggered
+     */
+    void check_watch(bool& do_break);
+
+    /**
+     * Set A and flags from ADC or SBC table.
+     * @param result table entry
+     */
+    void set_alu_result(const AluResult& result);
+
+    /**
+     * Binary add with carry to A, also used for SBC with inverted value.
+     * @param value value to add
+     */
+    void add(uint8_t value);
+
     /**
      * Implementation of ADC instruction.
      * @param value value to add
@@ -202,12 +477,11 @@ protected:
      */
     void SBC(uint8_t value);
 
-    Machine& machine;
+    Bus bus;
     Memory& memory;
 
     uint16_t PC;
     uint8_t SP;
-    bool quiet;
 
     bool irq_flag;
     bool nmi_flag;
@@ -217,12 +491,26 @@ protected:
     bool instruction_load;
     uint8_t instruction_cycles;
     uint8_t current_instruction;
+    uint16_t current_operand;
     uint8_t current_cycle;
 
-    Monitor monitor;
+    // Cycles left of the instruction exec_instruction() executes, zero otherwise.
+    uint8_t cycles_ahead;
+
+    // Value read by bus_cycle() for read-modify-write instructions.
+    uint8_t data_latch;
+
+    static const std::array<f_execute, 256> execute_table;
+    static const std::array<f_execute, 256> bus_timing_execute_table;
+    static const std::array<f_bus_cycle, 256> bus_cycle_handlers;
 
-    std::set<uint16_t> breakpoints;
-    bool has_breakpoints;
+    std::vector<DecodedInstruction> decode_cache;
+    DecodedInstruction decoded_uncached;
+
+    f_trap_handler trap_handler;
+    std::vector<bool> traps;
+
+    Monitor monitor;
 };
 
 #endif // MOS6502_H
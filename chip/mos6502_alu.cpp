@@ -0,0 +1,22 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include "mos6502_alu.hpp"
+
+
+constinit const AluTable adc_decimal_table = make_alu_table(false, true);
+constinit const AluTable sbc_decimal_table = make_alu_table(true, true);
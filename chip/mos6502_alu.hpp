@@ -0,0 +1,153 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// ADC and SBC results with flags. Decimal mode uses tables generated at compile
+// time, indexed by carry, A and operand, see alu_index(). Binary mode is cheaper
+// to calculate than to look up, so the CPU does it inline with lazy flags.
+// Decimal mode follows the NMOS 6502: N, V and Z are not valid BCD flags but
+// come from intermediate results, as on the real chip.
+
+#ifndef MOS6502_ALU_H
+#define MOS6502_ALU_H
+
+#include <array>
+#include <cstdint>
+
+#include "mos6502_opcodes.hpp"
+
+
+struct AluResult
+{
+    uint8_t value;
+    uint8_t flags;  // FLAG_N, FLAG_V, FLAG_Z and FLAG_C.
+};
+
+/**
+ * Processor status flags, each kept in the form instructions naturally produce
+ * it. Flags are only combined into a P byte when it is pushed or read.
+ */
+struct LazyFlags
+{
+    uint16_t c;     // Carry in bit 8, the ninth bit of a result.
+    uint8_t n;      // Negative in bit 7, usually the last result.
+    uint8_t z;      // Zero flag set when this is zero.
+    uint8_t v;      // Overflow in bit 6, as FLAG_V.
+    uint8_t p;      // Break, decimal and interrupt as FLAG_B, FLAG_D and FLAG_I.
+};
+
+constexpr uint32_t alu_table_size = 2 * 256 * 256;
+
+typedef std::array<AluResult, alu_table_size> AluTable;
+
+
+/**
+ * Get table index for an operation.
+ * @param carry carry flag before operation
+ * @param a accumulator
+ * @param value operand
+ * @return index in ALU tables
+ */
+constexpr uint32_t alu_index(bool carry, uint8_t a, uint8_t value)
+{
+    return carry << 16 | a << 8 | value;
+}
+
+/**
+ * Calculate ADC.
+ * @param carry carry flag before operation
+ * @param a accumulator
+ * @param value value to add
+ * @param decimal true for decimal mode
+ * @return new accumulator and flags
+ */
+constexpr AluResult alu_adc(bool carry, uint8_t a, uint8_t value, bool decimal)
+{
+    uint16_t w = a + value + carry;
+    if (! decimal) {
+        return {uint8_t(w), uint8_t((w & FLAG_N) | (~(a ^ value) & (a ^ w) & FLAG_N ? FLAG_V : 0) |
+                                    ((w & 0xff) ? 0 : FLAG_Z) | (w > 0xff ? FLAG_C : 0))};
+    }
+
+    uint16_t low = (a & 0x0f) + (value & 0x0f) + carry;
+    if (low > 9) {
+        low += 6;
+    }
+    uint16_t high = (a >> 4) + (value >> 4) + (low > 0x0f);
+
+    // Z from binary sum, N and V from high digit before decimal adjust.
+    uint8_t flags = ((w & 0xff) ? 0 : FLAG_Z) | ((high & 0x08) ? FLAG_N : 0) |
+                    ((~(a ^ value) & (a ^ (high << 4)) & 0x80) ? FLAG_V : 0);
+
+    if (high > 9) {
+        high += 6;
+    }
+    flags |= high > 0x0f ? FLAG_C : 0;
+    return {uint8_t((high << 4) | (low & 0x0f)), flags};
+}
+
+/**
+ * Calculate SBC.
+ * @param carry carry flag before operation, clear for borrow
+ * @param a accumulator
+ * @param value value to subtract
+ * @param decimal true for decimal mode
+ * @return new accumulator and flags
+ */
+constexpr AluResult alu_sbc(bool carry, uint8_t a, uint8_t value, bool decimal)
+{
+    // All flags are from the binary difference, also in decimal mode.
+    uint16_t w = a - value - ! carry;
+    uint8_t flags = (w & FLAG_N) | (((a ^ value) & (a ^ w) & 0x80) ? FLAG_V : 0) |
+                    ((w & 0xff) ? 0 : FLAG_Z) | (w < 0x100 ? FLAG_C : 0);
+    if (! decimal) {
+        return {uint8_t(w), flags};
+    }
+
+    uint16_t low = (a & 0x0f) - (value & 0x0f) - ! carry;
+    uint16_t high = (a >> 4) - (value >> 4);
+    if (low & 0x10) {
+        low -= 6;
+        --high;
+    }
+    if (high & 0x10) {
+        high -= 6;
+    }
+    return {uint8_t((high << 4) | (low & 0x0f)), flags};
+}
+
+/**
+ * Generate table for ADC or SBC.
+ * @param subtract true for SBC, false for ADC
+ * @param decimal true for decimal mode
+ * @return table indexed by alu_index()
+ */
+constexpr AluTable make_alu_table(bool subtract, bool decimal)
+{
+    AluTable table{};
+    for (uint32_t i = 0; i < alu_table_size; ++i) {
+        bool carry = i >> 16;
+        uint8_t a = i >> 8;
+        uint8_t value = i;
+        table[i] = subtract ? alu_sbc(carry, a, value, decimal) : alu_adc(carry, a, value, decimal);
+    }
+    return table;
+}
+
+extern const AluTable adc_decimal_table;
+extern const AluTable sbc_decimal_table;
+
+#endif // MOS6502_ALU_H
@@ -0,0 +1,106 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// Buses for MOS6502 that are not tied to a machine. The Oric bus is OricBus
+// in machine.hpp.
+
+#ifndef MOS6502_BUS_H
+#define MOS6502_BUS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "memory.hpp"
+
+
+/**
+ * Plain 64 KB RAM without I/O or ROM, for tests and CPU test programs.
+ */
+class FlatBus
+{
+public:
+    FlatBus(Memory& memory) : memory(memory) {}
+
+    uint8_t read_byte(uint16_t address) { return memory.mem[address]; }
+    uint8_t read_byte_zp(uint8_t address) { return memory.mem[address]; }
+
+    uint16_t read_word(uint16_t address)
+    {
+        return memory.mem[address] | memory.mem[(uint16_t)(address + 1)] << 8;
+    }
+
+    uint16_t read_word_zp(uint8_t address)
+    {
+        return memory.mem[address] | memory.mem[(address + 1) & 0xff] << 8;
+    }
+
+    void write_byte(uint16_t address, uint8_t val) { memory.mem[address] = val; }
+    void write_byte_zp(uint8_t address, uint8_t val) { memory.mem[address] = val; }
+
+    Memory& memory;
+};
+
+
+/**
+ * Flat RAM bus that records every access, for checking what an instruction
+ * touches. Stack accesses go directly to memory and are not recorded.
+ */
+class TracingBus : public FlatBus
+{
+public:
+    struct Access
+    {
+        uint16_t address;
+        uint8_t value;
+        bool write;
+
+        bool operator==(const Access& other) const = default;
+    };
+
+    TracingBus(Memory& memory) : FlatBus(memory) {}
+
+    uint8_t read_byte(uint16_t address)
+    {
+        uint8_t value = FlatBus::read_byte(address);
+        accesses.push_back({address, value, false});
+        return value;
+    }
+
+    uint8_t read_byte_zp(uint8_t address) { return read_byte(address); }
+
+    uint16_t read_word(uint16_t address)
+    {
+        return read_byte(address) | read_byte(address + 1) << 8;
+    }
+
+    uint16_t read_word_zp(uint8_t address)
+    {
+        return read_byte(address) | read_byte((address + 1) & 0xff) << 8;
+    }
+
+    void write_byte(uint16_t address, uint8_t val)
+    {
+        FlatBus::write_byte(address, val);
+        accesses.push_back({address, val, true});
+    }
+
+    void write_byte_zp(uint8_t address, uint8_t val) { write_byte(address, val); }
+
+    std::vector<Access> accesses;
+};
+
+#endif // MOS6502_BUS_H
@@ -0,0 +1,474 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// Description of every 6502 opcode: mnemonic, operation, addressing mode, base
+// cycles and how page crossings add cycles. The CPU generates its instruction
+// handlers from this table, and decodes and times instructions with it. The
+// monitor disassembles with it.
+//
+// bus_cycle_table is derived from it, with the memory accesses an instruction
+// does before its last cycle.
+
+#ifndef MOS6502_OPCODE_TABLE_H
+#define MOS6502_OPCODE_TABLE_H
+
+#include <array>
+#include <cstdint>
+
+
+enum class Addressing : uint8_t
+{
+    immediate,
+    absolute,
+    zero_page,
+    implied,
+    indirect_absolute,
+    absolute_indexed_x,
+    absolute_indexed_y,
+    zero_page_indexed_x,
+    zero_page_indexed_y,
+    indexed_indirect_x,
+    indirect_indexed_y,
+    relative,
+    accumulator
+};
+
+// Operations, named by mnemonic. Illegal opcodes that are emulated use the
+// mnemonic of what they do.
+enum class Operation : uint8_t
+{
+    adc, and_, asl, bcc, bcs, beq, bit, bmi, bne, bpl, brk, bvc, bvs, clc,
+    cld, cli, clv, cmp, cpx, cpy, dec, dex, dey, eor, inc, inx, iny, jmp,
+    jsr, lda, ldx, ldy, lsr, nop, ora, pha, php, pla, plp, rol, ror, rti,
+    rts, sbc, sec, sed, sei, sta, stx, sty, tax, tay, tsx, txa, txs, tya,
+    slo, rla,               // Illegal.
+    hle_trap,               // Trapped address, see HLE_TRAP.
+    unknown                 // Not emulated, stops the CPU.
+};
+
+// How cycles are added to base cycles of an instruction.
+enum Timing : uint8_t
+{
+    TIMING_FIXED,
+    TIMING_ABS_X,       // One extra cycle if operand + X crosses page.
+    TIMING_ABS_Y,       // One extra cycle if operand + Y crosses page.
+    TIMING_IND_Y,       // One extra cycle if zero page pointer + Y crosses page.
+    TIMING_BRANCH       // One extra cycle if branch is taken, two if to another page.
+};
+
+
+struct OpcodeInfo
+{
+    const char* name;       // Mnemonic, in parentheses for illegal opcodes. nullptr if unknown.
+    Operation operation;
+    Addressing addressing;
+    uint8_t cycles;         // Cycles without page crossings or taken branch.
+    Timing timing;
+    uint8_t length;         // Instruction length in bytes, including opcode.
+};
+
+
+/**
+ * Get instruction length for an addressing mode.
+ * @param addressing addressing mode
+ * @return instruction length in bytes, including opcode
+ */
+constexpr uint8_t addressing_length(Addressing addressing)
+{
+    switch (addressing) {
+        case Addressing::implied:
+        case Addressing::accumulator:
+            return 1;
+        case Addressing::absolute:
+        case Addressing::indirect_absolute:
+        case Addressing::absolute_indexed_x:
+        case Addressing::absolute_indexed_y:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+/**
+ * Check if an addressing mode only accesses zero page.
+ * @param addressing addressing mode
+ * @return true for zero page addressing modes
+ */
+constexpr bool is_zero_page(Addressing addressing)
+{
+    return addressing == Addressing::zero_page || addressing == Addressing::zero_page_indexed_x ||
+           addressing == Addressing::zero_page_indexed_y;
+}
+
+/**
+ * Create opcode table entry.
+ * @param name mnemonic
+ * @param operation operation
+ * @param addressing addressing mode
+ * @param cycles base cycles
+ * @param timing how cycles are added for page crossings and branches
+ * @return opcode table entry
+ */
+constexpr OpcodeInfo opcode(const char* name, Operation operation, Addressing addressing, uint8_t cycles,
+                            Timing timing = TIMING_FIXED)
+{
+    return {name, operation, addressing, cycles, timing, addressing_length(addressing)};
+}
+
+constexpr OpcodeInfo unknown_opcode = opcode(nullptr, Operation::unknown, Addressing::implied, 0);
+
+
+constexpr std::array<OpcodeInfo, 256> opcode_table = {
+    // 0x00
+    opcode("BRK", Operation::brk, Addressing::implied, 7),
+    opcode("ORA", Operation::ora, Addressing::indexed_indirect_x, 6),
+    opcode(nullptr, Operation::hle_trap, Addressing::implied, 0),     // JAM, see HLE_TRAP.
+    opcode("(SLO)", Operation::slo, Addressing::indexed_indirect_x, 8),
+    opcode("(NOP)", Operation::nop, Addressing::zero_page, 3),
+    opcode("ORA", Operation::ora, Addressing::zero_page, 3),
+    opcode("ASL", Operation::asl, Addressing::zero_page, 5),
+    unknown_opcode,
+    opcode("PHP", Operation::php, Addressing::implied, 3),
+    opcode("ORA", Operation::ora, Addressing::immediate, 2),
+    opcode("ASL", Operation::asl, Addressing::accumulator, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute, 4),
+    opcode("ORA", Operation::ora, Addressing::absolute, 4),
+    opcode("ASL", Operation::asl, Addressing::absolute, 6),
+    unknown_opcode,
+    // 0x10
+    opcode("BPL", Operation::bpl, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("ORA", Operation::ora, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    opcode("(SLO)", Operation::slo, Addressing::indirect_indexed_y, 8),
+    opcode("(NOP)", Operation::nop, Addressing::zero_page_indexed_x, 4),
+    opcode("ORA", Operation::ora, Addressing::zero_page_indexed_x, 4),
+    opcode("ASL", Operation::asl, Addressing::zero_page_indexed_x, 6),
+    unknown_opcode,
+    opcode("CLC", Operation::clc, Addressing::implied, 2),
+    opcode("ORA", Operation::ora, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("(NOP)", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("ORA", Operation::ora, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("ASL", Operation::asl, Addressing::absolute_indexed_x, 7),
+    unknown_opcode,
+    // 0x20
+    opcode("JSR", Operation::jsr, Addressing::absolute, 6),
+    opcode("AND", Operation::and_, Addressing::indexed_indirect_x, 6),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("BIT", Operation::bit, Addressing::zero_page, 3),
+    opcode("AND", Operation::and_, Addressing::zero_page, 3),
+    opcode("ROL", Operation::rol, Addressing::zero_page, 5),
+    unknown_opcode,
+    opcode("PLP", Operation::plp, Addressing::implied, 4),
+    opcode("AND", Operation::and_, Addressing::immediate, 2),
+    opcode("ROL", Operation::rol, Addressing::accumulator, 2),
+    unknown_opcode,
+    opcode("BIT", Operation::bit, Addressing::absolute, 4),
+    opcode("AND", Operation::and_, Addressing::absolute, 4),
+    opcode("ROL", Operation::rol, Addressing::absolute, 6),
+    unknown_opcode,
+    // 0x30
+    opcode("BMI", Operation::bmi, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("AND", Operation::and_, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    opcode("(RLA)", Operation::rla, Addressing::indirect_indexed_y, 8),
+    opcode("(NOP)", Operation::nop, Addressing::zero_page_indexed_x, 4),
+    opcode("AND", Operation::and_, Addressing::zero_page_indexed_x, 4),
+    opcode("ROL", Operation::rol, Addressing::zero_page_indexed_x, 6),
+    unknown_opcode,
+    opcode("SEC", Operation::sec, Addressing::implied, 2),
+    opcode("AND", Operation::and_, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("(NOP)", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("AND", Operation::and_, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("ROL", Operation::rol, Addressing::absolute_indexed_x, 7),
+    unknown_opcode,
+    // 0x40
+    opcode("RTI", Operation::rti, Addressing::implied, 6),
+    opcode("EOR", Operation::eor, Addressing::indexed_indirect_x, 6),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::zero_page, 3),
+    opcode("EOR", Operation::eor, Addressing::zero_page, 3),
+    opcode("LSR", Operation::lsr, Addressing::zero_page, 5),
+    unknown_opcode,
+    opcode("PHA", Operation::pha, Addressing::implied, 3),
+    opcode("EOR", Operation::eor, Addressing::immediate, 2),
+    opcode("LSR", Operation::lsr, Addressing::accumulator, 2),
+    unknown_opcode,
+    opcode("JMP", Operation::jmp, Addressing::absolute, 3),
+    opcode("EOR", Operation::eor, Addressing::absolute, 4),
+    opcode("LSR", Operation::lsr, Addressing::absolute, 6),
+    unknown_opcode,
+    // 0x50
+    opcode("BVC", Operation::bvc, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("EOR", Operation::eor, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::zero_page_indexed_x, 4),
+    opcode("EOR", Operation::eor, Addressing::zero_page_indexed_x, 4),
+    opcode("LSR", Operation::lsr, Addressing::zero_page_indexed_x, 6),
+    unknown_opcode,
+    opcode("CLI", Operation::cli, Addressing::implied, 2),
+    opcode("EOR", Operation::eor, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("(NOP)", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("EOR", Operation::eor, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("LSR", Operation::lsr, Addressing::absolute_indexed_x, 7),
+    unknown_opcode,
+    // 0x60
+    opcode("RTS", Operation::rts, Addressing::implied, 6),
+    opcode("ADC", Operation::adc, Addressing::indexed_indirect_x, 6),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::zero_page, 3),
+    opcode("ADC", Operation::adc, Addressing::zero_page, 3),
+    opcode("ROR", Operation::ror, Addressing::zero_page, 5),
+    unknown_opcode,
+    opcode("PLA", Operation::pla, Addressing::implied, 4),
+    opcode("ADC", Operation::adc, Addressing::immediate, 2),
+    opcode("ROR", Operation::ror, Addressing::accumulator, 2),
+    unknown_opcode,
+    opcode("JMP", Operation::jmp, Addressing::indirect_absolute, 5),
+    opcode("ADC", Operation::adc, Addressing::absolute, 4),
+    opcode("ROR", Operation::ror, Addressing::absolute, 6),
+    unknown_opcode,
+    // 0x70
+    opcode("BVS", Operation::bvs, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("ADC", Operation::adc, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::zero_page_indexed_x, 4),
+    opcode("ADC", Operation::adc, Addressing::zero_page_indexed_x, 4),
+    opcode("ROR", Operation::ror, Addressing::zero_page_indexed_x, 6),
+    unknown_opcode,
+    opcode("SEI", Operation::sei, Addressing::implied, 2),
+    opcode("ADC", Operation::adc, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("(NOP)", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("ADC", Operation::adc, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("ROR", Operation::ror, Addressing::absolute_indexed_x, 7),
+    unknown_opcode,
+    // 0x80
+    opcode("(NOP)", Operation::nop, Addressing::immediate, 2),
+    opcode("STA", Operation::sta, Addressing::indexed_indirect_x, 6),
+    opcode("(NOP)", Operation::nop, Addressing::immediate, 2),
+    unknown_opcode,
+    opcode("STY", Operation::sty, Addressing::zero_page, 3),
+    opcode("STA", Operation::sta, Addressing::zero_page, 3),
+    opcode("STX", Operation::stx, Addressing::zero_page, 3),
+    unknown_opcode,
+    opcode("DEY", Operation::dey, Addressing::implied, 2),
+    opcode("(NOP)", Operation::nop, Addressing::immediate, 2),
+    opcode("TXA", Operation::txa, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("STY", Operation::sty, Addressing::absolute, 4),
+    opcode("STA", Operation::sta, Addressing::absolute, 4),
+    opcode("STX", Operation::stx, Addressing::absolute, 4),
+    unknown_opcode,
+    // 0x90
+    opcode("BCC", Operation::bcc, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("STA", Operation::sta, Addressing::indirect_indexed_y, 6),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("STY", Operation::sty, Addressing::zero_page_indexed_x, 4),
+    opcode("STA", Operation::sta, Addressing::zero_page_indexed_x, 4),
+    opcode("STX", Operation::stx, Addressing::zero_page_indexed_y, 4),
+    unknown_opcode,
+    opcode("TYA", Operation::tya, Addressing::implied, 2),
+    opcode("STA", Operation::sta, Addressing::absolute_indexed_y, 5),
+    opcode("TXS", Operation::txs, Addressing::implied, 2),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("STA", Operation::sta, Addressing::absolute_indexed_x, 5),
+    unknown_opcode,
+    unknown_opcode,
+    // 0xA0
+    opcode("LDY", Operation::ldy, Addressing::immediate, 2),
+    opcode("LDA", Operation::lda, Addressing::indexed_indirect_x, 6),
+    opcode("LDX", Operation::ldx, Addressing::immediate, 2),
+    unknown_opcode,
+    opcode("LDY", Operation::ldy, Addressing::zero_page, 3),
+    opcode("LDA", Operation::lda, Addressing::zero_page, 3),
+    opcode("LDX", Operation::ldx, Addressing::zero_page, 3),
+    unknown_opcode,
+    opcode("TAY", Operation::tay, Addressing::implied, 2),
+    opcode("LDA", Operation::lda, Addressing::immediate, 2),
+    opcode("TAX", Operation::tax, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("LDY", Operation::ldy, Addressing::absolute, 4),
+    opcode("LDA", Operation::lda, Addressing::absolute, 4),
+    opcode("LDX", Operation::ldx, Addressing::absolute, 4),
+    unknown_opcode,
+    // 0xB0
+    opcode("BCS", Operation::bcs, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("LDA", Operation::lda, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("LDY", Operation::ldy, Addressing::zero_page_indexed_x, 4),
+    opcode("LDA", Operation::lda, Addressing::zero_page_indexed_x, 4),
+    opcode("LDX", Operation::ldx, Addressing::zero_page_indexed_y, 4),
+    unknown_opcode,
+    opcode("CLV", Operation::clv, Addressing::implied, 2),
+    opcode("LDA", Operation::lda, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("TSX", Operation::tsx, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("LDY", Operation::ldy, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("LDA", Operation::lda, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("LDX", Operation::ldx, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    unknown_opcode,
+    // 0xC0
+    opcode("CPY", Operation::cpy, Addressing::immediate, 2),
+    opcode("CMP", Operation::cmp, Addressing::indexed_indirect_x, 6),
+    opcode("(NOP)", Operation::nop, Addressing::immediate, 2),
+    unknown_opcode,
+    opcode("CPY", Operation::cpy, Addressing::zero_page, 3),
+    opcode("CMP", Operation::cmp, Addressing::zero_page, 3),
+    opcode("DEC", Operation::dec, Addressing::zero_page, 5),
+    unknown_opcode,
+    opcode("INY", Operation::iny, Addressing::implied, 2),
+    opcode("CMP", Operation::cmp, Addressing::immediate, 2),
+    opcode("DEX", Operation::dex, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("CPY", Operation::cpy, Addressing::absolute, 4),
+    opcode("CMP", Operation::cmp, Addressing::absolute, 4),
+    opcode("DEC", Operation::dec, Addressing::absolute, 6),
+    unknown_opcode,
+    // 0xD0
+    opcode("BNE", Operation::bne, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("CMP", Operation::cmp, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::zero_page_indexed_x, 4),
+    opcode("CMP", Operation::cmp, Addressing::zero_page_indexed_x, 4),
+    opcode("DEC", Operation::dec, Addressing::zero_page_indexed_x, 6),
+    unknown_opcode,
+    opcode("CLD", Operation::cld, Addressing::implied, 2),
+    opcode("CMP", Operation::cmp, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("(NOP)", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("CMP", Operation::cmp, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("DEC", Operation::dec, Addressing::absolute_indexed_x, 7),
+    unknown_opcode,
+    // 0xE0
+    opcode("CPX", Operation::cpx, Addressing::immediate, 2),
+    opcode("SBC", Operation::sbc, Addressing::indexed_indirect_x, 6),
+    opcode("(NOP)", Operation::nop, Addressing::immediate, 2),
+    unknown_opcode,
+    opcode("CPX", Operation::cpx, Addressing::zero_page, 3),
+    opcode("SBC", Operation::sbc, Addressing::zero_page, 3),
+    opcode("INC", Operation::inc, Addressing::zero_page, 5),
+    unknown_opcode,
+    opcode("INX", Operation::inx, Addressing::implied, 2),
+    opcode("SBC", Operation::sbc, Addressing::immediate, 2),
+    opcode("NOP", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("CPX", Operation::cpx, Addressing::absolute, 4),
+    opcode("SBC", Operation::sbc, Addressing::absolute, 4),
+    opcode("INC", Operation::inc, Addressing::absolute, 6),
+    unknown_opcode,
+    // 0xF0
+    opcode("BEQ", Operation::beq, Addressing::relative, 2, TIMING_BRANCH),
+    opcode("SBC", Operation::sbc, Addressing::indirect_indexed_y, 5, TIMING_IND_Y),
+    unknown_opcode,
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::zero_page_indexed_x, 4),
+    opcode("SBC", Operation::sbc, Addressing::zero_page_indexed_x, 4),
+    opcode("INC", Operation::inc, Addressing::zero_page_indexed_x, 6),
+    unknown_opcode,
+    opcode("SED", Operation::sed, Addressing::implied, 2),
+    opcode("SBC", Operation::sbc, Addressing::absolute_indexed_y, 4, TIMING_ABS_Y),
+    opcode("(NOP)", Operation::nop, Addressing::implied, 2),
+    unknown_opcode,
+    opcode("(NOP)", Operation::nop, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("SBC", Operation::sbc, Addressing::absolute_indexed_x, 4, TIMING_ABS_X),
+    opcode("INC", Operation::inc, Addressing::absolute_indexed_x, 7),
+    unknown_opcode,
+
+};
+
+
+// Memory accesses before the last cycle of an instruction, that can have side
+// effects on I/O. Opcode and operand fetches, zero page pointers and stack are
+// left out, as they are RAM or ROM. All other accesses are done on the last cycle.
+enum class BusOp : uint8_t
+{
+    none,
+    page_cross_read,    // Read at indexed address before carry to high byte, if index crosses page.
+    dummy_read,         // Read at indexed address before carry to high byte, also without page crossing.
+    read,               // Read of value to modify.
+    dummy_write         // Write of unmodified value.
+};
+
+// Bus operations by cycles left of instruction, [1] is the cycle before the last.
+typedef std::array<BusOp, 4> BusCycles;
+
+
+/**
+ * Get bus operations before the last cycle of an instruction, as the NMOS 6502 does them.
+ * @param info opcode table entry
+ * @return bus operations by cycles left
+ */
+constexpr BusCycles bus_cycles(const OpcodeInfo& info)
+{
+    bool indexed = info.addressing == Addressing::absolute_indexed_x ||
+                   info.addressing == Addressing::absolute_indexed_y ||
+                   info.addressing == Addressing::indirect_indexed_y;
+
+    switch (info.operation) {
+        case Operation::asl: case Operation::lsr: case Operation::rol: case Operation::ror:
+        case Operation::inc: case Operation::dec: case Operation::slo: case Operation::rla:
+            if (info.addressing == Addressing::accumulator) {
+                return {};
+            }
+            return {BusOp::none, BusOp::dummy_write, BusOp::read, indexed ? BusOp::dummy_read : BusOp::none};
+
+        case Operation::sta: case Operation::stx: case Operation::sty:
+            return {BusOp::none, indexed ? BusOp::dummy_read : BusOp::none};
+
+        case Operation::nop:
+        case Operation::jmp:
+            return {};
+
+        default:
+            return {BusOp::none, indexed ? BusOp::page_cross_read : BusOp::none};
+    }
+}
+
+/**
+ * Generate bus operations for all opcodes.
+ * @return table indexed by opcode
+ */
+constexpr std::array<BusCycles, 256> make_bus_cycle_table()
+{
+    std::array<BusCycles, 256> table{};
+    for (uint32_t opcode = 0; opcode < 256; ++opcode) {
+        table[opcode] = bus_cycles(opcode_table[opcode]);
+    }
+    return table;
+}
+
+constexpr std::array<BusCycles, 256> bus_cycle_table = make_bus_cycle_table();
+
+#endif // MOS6502_OPCODE_TABLE_H
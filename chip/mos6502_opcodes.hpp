@@ -257,5 +257,8 @@
 
 #define ILL_ISC_ABS_X 0xFF
 
+// JAM opcode, replaces the opcode of trapped addresses when decoding.
+#define HLE_TRAP      0x02
+
 
 #endif // MOS6502_OPCODES_H
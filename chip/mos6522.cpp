@@ -15,6 +15,7 @@
 //   along with this program.  If not, see <http://www.gnu.org/licenses/>
 // =========================================================================
 
+#include <algorithm>
 #include <vector>
 #include <stack>
 #include <utility>
@@ -68,17 +69,23 @@ void MOS6522::State::reset()
     orb = 0x00;         // output register B
     ddrb = 0x00;        // data direction register B
 
+    cycle = 0;
+
     t1_latch_low = 0;
     t1_latch_high = 0;
     t1_counter = 0;
     t1_run = false;
     t1_reload = 0;
+    t1_cycle = 0;
+    t1_expiry = UINT64_MAX;
 
     t2_latch_low = 0;
     t2_latch_high = 0;
     t2_counter = 0;
     t2_run = false;
     t2_reload = false;
+    t2_cycle = 0;
+    t2_expiry = UINT64_MAX;
 
     sr = 0;             // Shift Register
     sr_counter = 0;     // Modulo 8 counter for current bit
@@ -175,67 +182,14 @@ void MOS6522::exec()
         if (cb2_changed_handler) { cb2_changed_handler(machine, state.cb2); }
     }
 
-    switch (state.acr & 0xc0)
-    {
-        case 0x00:
-        case 0x80:
-            // T1 - One shot
-            if (state.t1_reload) {
-                --state.t1_reload;
-                if (state.t1_reload == 0) {
-                    state.t1_counter = (state.t1_latch_high << 8) | state.t1_latch_low;
-                }
-            }
-            else {
-                if (state.t1_run && state.t1_counter == 0) {
-                    irq_set(IRQ_T1);
-                    if (state.acr & 0x80) {
-                        state.orb |= 0x80;    // Output 1 on PB7 if ACR7 is set.
-                    }
-                    state.t1_run = false;
-                }
-                --state.t1_counter;
-            }
-            break;
-        case 0x40:
-        case 0xC0:
-            // T1 - Continuous
-            if (state.t1_reload) {
-                --state.t1_reload;
-                if (state.t1_reload == 0) {
-                    state.t1_counter = (state.t1_latch_high << 8) | state.t1_latch_low;
-                }
-            }
-            else {
-                if (state.t1_counter == 0) {
-                    irq_set(IRQ_T1);
-
-                    if (state.acr & 0x80) {
-                        state.orb ^= 0x80;    // Output squarewave on PB7 if ACR7 is set.
-                    }
-
-                    state.t1_reload = 1;
-                }
-
-                --state.t1_counter;
-            }
+    ++state.cycle;
 
-            break;
+    if (state.cycle >= state.t1_expiry) {
+        t1_sync();
     }
 
-    if (!(state.acr & 0x20)) {
-        // T2 - One shot (pulse counting mode handled in set_irb_bit)
-        if (state.t2_reload) {
-            state.t2_reload = false;
-        }
-        else {
-            if (state.t2_run && (state.t2_counter == 0)) {
-                irq_set(IRQ_T2);
-                state.t2_run = false;
-            }
-
-            --state.t2_counter;
-        }
+    if (state.cycle >= state.t2_expiry) {
+        t2_sync();
     }
 
     switch (state.acr & 0x1c)
@@ -321,6 +275,131 @@ void MOS6522::exec()
     }
 }
 
+void MOS6522::exec(uint32_t cycles)
+{
+    while (cycles) {
+        uint32_t step = std::min(cycles, cycles_to_next_event() - 1);
+        if (step == 0) {
+            exec();
+            --cycles;
+            continue;
+        }
+
+        // Nothing happens until the next event, timers are updated lazily.
+        state.cycle += step;
+        cycles -= step;
+    }
+}
+
+uint32_t MOS6522::cycles_to_next_event()
+{
+    // Pulses and shifting need per cycle handling.
+    bool sr_idle = (state.acr & 0x1c) == 0x00 || (! state.sr_run && (state.acr & 0x0c) != 0x0c);
+    if (state.ca2_do_pulse || state.cb2_do_pulse || ! sr_idle) {
+        return 1;
+    }
+
+    uint64_t expiry = std::min(state.t1_expiry, state.t2_expiry);
+    if (expiry - state.cycle >= UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    return expiry - state.cycle;
+}
+
+void MOS6522::t1_sync()
+{
+    uint64_t n = state.cycle - state.t1_cycle;
+    state.t1_cycle = state.cycle;
+    if (n == 0) {
+        return;
+    }
+
+    bool continuous = state.acr & 0x40;
+    uint16_t latch = (state.t1_latch_high << 8) | state.t1_latch_low;
+
+    while (n) {
+        if (state.t1_reload) {
+            // Reloading from latch takes one cycle.
+            state.t1_reload = 0;
+            state.t1_counter = latch;
+            --n;
+            continue;
+        }
+
+        // Counter is found to be zero after counter + 1 cycles.
+        if (! (continuous || state.t1_run) || state.t1_counter >= n) {
+            state.t1_counter = (uint16_t)(state.t1_counter - n);
+            break;
+        }
+
+        n -= state.t1_counter + 1;
+        state.t1_counter = 0xffff;
+        irq_set(IRQ_T1);
+
+        if (continuous) {
+            if (state.acr & 0x80) {
+                state.orb ^= 0x80;    // Output squarewave on PB7 if ACR7 is set.
+            }
+            state.t1_reload = 1;
+        }
+        else {
+            if (state.acr & 0x80) {
+                state.orb |= 0x80;    // Output 1 on PB7 if ACR7 is set.
+            }
+            state.t1_run = false;
+        }
+    }
+
+    t1_update_expiry();
+}
+
+void MOS6522::t2_sync()
+{
+    uint64_t n = state.cycle - state.t2_cycle;
+    state.t2_cycle = state.cycle;
+
+    // In pulse counting mode T2 is only counted in set_irb_bit.
+    if (n == 0 || (state.acr & 0x20)) {
+        return;
+    }
+
+    if (state.t2_reload) {
+        state.t2_reload = false;
+        --n;
+    }
+
+    if (state.t2_run && state.t2_counter < n) {
+        irq_set(IRQ_T2);
+        state.t2_run = false;
+    }
+    state.t2_counter = (uint16_t)(state.t2_counter - n);
+
+    t2_update_expiry();
+}
+
+void MOS6522::t1_update_expiry()
+{
+    if (! ((state.acr & 0x40) || state.t1_run)) {
+        state.t1_expiry = UINT64_MAX;
+    }
+    else if (state.t1_reload) {
+        state.t1_expiry = state.t1_cycle + ((state.t1_latch_high << 8) | state.t1_latch_low) + 2;
+    }
+    else {
+        state.t1_expiry = state.t1_cycle + state.t1_counter + 1;
+    }
+}
+
+void MOS6522::t2_update_expiry()
+{
+    if ((state.acr & 0x20) || ! state.t2_run) {
+        state.t2_expiry = UINT64_MAX;
+    }
+    else {
+        state.t2_expiry = state.t2_cycle + state.t2_counter + (state.t2_reload ? 2 : 1);
+    }
+}
+
 uint8_t MOS6522::read_byte(uint16_t offset)
 {
     switch(offset & 0x000f)
@@ -378,18 +457,22 @@ uint8_t MOS6522::read_byte(uint16_t offset)
         case DDRA:
             return state.ddra;
         case T1C_L:
+            t1_sync();
             irq_clear(IRQ_T1);
             return state.t1_counter & 0x00ff;
         case T1C_H:
+            t1_sync();
             return state.t1_counter >> 8;
         case T1L_L:
             return state.t1_latch_low;
         case T1L_H:
             return state.t1_latch_high;
         case T2C_L:
+            t2_sync();
             irq_clear(IRQ_T2);
             return state.t2_counter & 0x00ff;
         case T2C_H:
+            t2_sync();
             return state.t2_counter >> 8;
         case SR:
             state.sr_timer = 0;
@@ -467,9 +550,12 @@ void MOS6522::write_byte(uint16_t offset, uint8_t value)
             state.ddra = value;
             break;
         case T1C_L:
+            t1_sync();
             state.t1_latch_low = value;
+            t1_update_expiry();
             break;
         case T1C_H:
+            t1_sync();
             state.t1_latch_high = value;
             state.t1_counter = (state.t1_latch_high << 8) | state.t1_latch_low;
             state.t1_reload = true;
@@ -479,23 +565,30 @@ void MOS6522::write_byte(uint16_t offset, uint8_t value)
             if ((state.acr & 0xc0) == 0x80) {
                 state.orb &= 0x7f;
             }
+            t1_update_expiry();
             break;
         case T1L_L:
+            t1_sync();
             state.t1_latch_low = value;
+            t1_update_expiry();
             break;
         case T1L_H:
+            t1_sync();
             state.t1_latch_high = value;
             irq_clear(IRQ_T1);
+            t1_update_expiry();
             break;
         case T2C_L:
             state.t2_latch_low = value;
             break;
         case T2C_H:
+            t2_sync();
             state.t2_latch_high = value;
             state.t2_counter = (state.t2_latch_high << 8) | state.t2_latch_low;
             state.t2_run = true;
             state.t2_reload = true;
             irq_clear(IRQ_T2);
+            t2_update_expiry();
             break;
         case SR:
             state.sr = value;
@@ -505,10 +598,14 @@ void MOS6522::write_byte(uint16_t offset, uint8_t value)
             irq_clear(IRQ_SR);
             break;
         case ACR:
+            t1_sync();
+            t2_sync();
             state.acr = value;
             if( ( ( value & 0xc0 ) != 0x40 ) &&
                 ( ( value & 0xc0 ) != 0xc0 ) )
                 state.t1_reload = false;
+            t1_update_expiry();
+            t2_update_expiry();
             break;
         case PCR:
             state.pcr = value;
@@ -580,6 +677,7 @@ void MOS6522::set_irb_bit(const uint8_t bit, const bool value)
 
     if (state.acr & 0x20) {
         if (bit == 6 && (original_bit_6 & 0x40) && !value) {
+            t2_sync();
             state.t2_counter--;
             if (state.t2_run && (state.t2_counter == 0)) {
 
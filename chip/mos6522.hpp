@@ -97,17 +97,25 @@ public:
         uint8_t orb;		// Output Register B
         uint8_t ddrb;		// Data Direction Register B (input = 0, output = 1)
 
+        // Timers are updated lazily: counters hold their value at t1_cycle/t2_cycle and are
+        // brought up to date on access, or when the cycle counter reaches the next expiry.
+        uint64_t cycle;     // Cycles executed
+
         uint8_t t1_latch_low;
         uint8_t t1_latch_high;
         uint16_t t1_counter;
         bool t1_run;
         uint8_t t1_reload;
+        uint64_t t1_cycle;  // Cycle when t1_counter was last updated
+        uint64_t t1_expiry; // Cycle when T1 next reaches zero
 
         uint8_t t2_latch_low;
         uint8_t t2_latch_high;
         uint16_t t2_counter;
         bool t2_run;
         bool t2_reload;
+        uint64_t t2_cycle;  // Cycle when t2_counter was last updated
+        uint64_t t2_expiry; // Cycle when T2 next reaches zero
 
         uint8_t sr;         // Shift register
         uint8_t sr_counter; // Modulo 8 counter for current bit
@@ -153,6 +161,20 @@ public:
      */
     void exec();
 
+    /**
+     * Execute a number of clock cycles.
+     * Idle stretches are skipped in one step, anything else falls back to exec() per cycle.
+     * @param cycles number of cycles to execute
+     */
+    void exec(uint32_t cycles);
+
+    /**
+     * Get number of cycles until something happens that needs exec() per cycle,
+     * like a timer reaching zero, a pulse ending or shift register activity.
+     * @return cycles until next event (1 means next cycle), UINT32_MAX if none
+     */
+    uint32_t cycles_to_next_event();
+
     /**
      * Save MOS 6522 state to snapshot.
      * @param snapshot reference to snapshot
@@ -233,21 +255,21 @@ public:
      * Return reference ot current MOS 6522 state.
      * @return reference to current MOS 6522 state
      */
-    MOS6522::State& get_state() { return state; }
+    MOS6522::State& get_state() { t1_sync(); t2_sync(); return state; }
 
     /**
      * Get value of T1 counter.
      * @return value of T1 counter
      * Mainly used by unit tests to be able to get and set values without affecting interrupt flags.
      */
-    uint16_t get_t1_counter() { return state.t1_counter; }
+    uint16_t get_t1_counter() { t1_sync(); return state.t1_counter; }
 
     /**
      * Get value of T2 counter.
      * @return value of T2 counter
      * Mainly used by unit tests to be able to get and set values without affecting interrupt flags.
      */
-    uint16_t get_t2_counter() { return state.t2_counter; }
+    uint16_t get_t2_counter() { t2_sync(); return state.t2_counter; }
 
     /**
      * Set IFR (interrupt flag register) value
@@ -265,6 +287,26 @@ public:
     f_irq_clear_handler irq_clear_handler;
 
 private:
+    /**
+     * Bring T1 up to current cycle, triggering any expiries on the way.
+     */
+    void t1_sync();
+
+    /**
+     * Bring T2 up to current cycle, triggering any expiry on the way.
+     */
+    void t2_sync();
+
+    /**
+     * Calculate cycle of next T1 expiry from current T1 state.
+     */
+    void t1_update_expiry();
+
+    /**
+     * Calculate cycle of next T2 expiry from current T2 state.
+     */
+    void t2_update_expiry();
+
     void irq_check();
     void irq_set(uint8_t bits);
     void irq_clear(uint8_t bits);
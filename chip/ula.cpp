@@ -15,6 +15,9 @@
 //   along with this program.  If not, see <http://www.gnu.org/licenses/>
 // =========================================================================
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <vector>
 #include <stack>
 #include <utility>
@@ -26,12 +29,72 @@
 
 constexpr uint16_t raster_max = 312;
 
-constexpr uint16_t raster_visible_lines = 224;
+constexpr uint16_t raster_visible_lines = ULA::visible_lines;
 //constexpr uint16_t raster_visible_first = 65;
 constexpr uint16_t raster_visible_first = 44;
 constexpr uint16_t raster_visible_last = raster_visible_first + raster_visible_lines;
 
 
+// Pixel masks of each 6 pixel pattern, 0xff for foreground pixels. Padded to
+// 8 bytes to be blended as one 64 bit word.
+typedef std::array<uint8_t, 8> PatternMask;
+
+constexpr std::array<PatternMask, 64> make_pattern_masks()
+{
+    std::array<PatternMask, 64> masks{};
+    for (uint8_t pattern = 0; pattern < 64; ++pattern) {
+        for (uint8_t pixel = 0; pixel < 6; ++pixel) {
+            masks[pattern][pixel] = (pattern & (0x20 >> pixel)) ? 0xff : 0;
+        }
+    }
+    return masks;
+}
+
+constexpr std::array<PatternMask, 64> pattern_masks = make_pattern_masks();
+
+
+/**
+ * Paint the 6 pixels of a character cell from a pixel mask.
+ * @param texture pixels to paint
+ * @param mask pixel mask, 0xff in the bytes of foreground pixels
+ * @param fg_col foreground color index
+ * @param bg_col background color index
+ */
+inline void blend_cell(uint8_t* texture, uint64_t mask, uint8_t fg_col, uint8_t bg_col)
+{
+    // Same value in all bytes, so byte order does not matter.
+    uint64_t bg = bg_col * 0x0101010101010101ull;
+    uint64_t cell = bg ^ ((fg_col ^ bg_col) * 0x0101010101010101ull & mask);
+    memcpy(texture, &cell, 6);
+}
+
+/**
+ * Paint the 6 pixels of a character cell.
+ * @tparam Vector true to blend with pattern_masks in one 64 bit word, false for plain selects
+ * @param texture pixels to paint
+ * @param pattern 6 bit pattern, set bits are foreground
+ * @param fg_col foreground color index
+ * @param bg_col background color index
+ */
+template <bool Vector>
+inline void paint_cell(uint8_t* texture, uint8_t pattern, uint8_t fg_col, uint8_t bg_col)
+{
+    if constexpr (Vector) {
+        uint64_t mask;
+        memcpy(&mask, pattern_masks[pattern].data(), sizeof(mask));
+        blend_cell(texture, mask, fg_col, bg_col);
+    }
+    else {
+        texture[0] = (pattern & 0x20) ? fg_col : bg_col;
+        texture[1] = (pattern & 0x10) ? fg_col : bg_col;
+        texture[2] = (pattern & 0x08) ? fg_col : bg_col;
+        texture[3] = (pattern & 0x04) ? fg_col : bg_col;
+        texture[4] = (pattern & 0x02) ? fg_col : bg_col;
+        texture[5] = (pattern & 0x01) ? fg_col : bg_col;
+    }
+}
+
+
 ULA::ULA(Machine* machine, Memory* memory, uint8_t texture_width, uint8_t texture_height, uint8_t texture_bpp) :
     machine(machine),
     memory(memory),
@@ -39,13 +102,87 @@ ULA::ULA(Machine* machine, Memory* memory, uint8_t texture_width, uint8_t textur
     texture_height(texture_height),
     texture_bpp(texture_bpp),
     raster_current(0),
-    video_attrib(0),
-    text_attrib(0),
     warpmode_counter(0),
-    blink(0x3f),
-    frame_count(0)
+    frame_count(0),
+    write_serial(1),
+    rows_written{},
+    charsets_written(1),
+    charset_written{1, 1, 1, 1},
+    charsets_captured(0),
+    lines_captured{},
+    captures{},
+    capture_index(0),
+    video_attrib(0),
+    paint_serial(0),
+    charsets_changed{},
+    charsets{},
+    glyph_masks{},
+    lines{},
+    vector_paint(true),
+    frame_pending(false),
+    stopping(false),
+    frame_back(0),
+    frame_front(1),
+    frame_ready(2)
+{
+    pixels = std::vector<uint8_t>(Frontend::texture_width * Frontend::texture_height, 0);
+    for (std::vector<uint8_t>& frame : frames) {
+        frame = pixels;
+    }
+    for (FrameCapture& frame : captures) {
+        for (LineCapture& line : frame.lines) {
+            line.charsets = -1;
+        }
+    }
+}
+
+ULA::~ULA()
+{
+    set_threaded(false);
+}
+
+
+void ULA::mark_written(uint16_t address, uint32_t length)
+{
+    uint32_t start = std::max<uint32_t>(address, video_memory_start);
+    uint32_t end = std::min<uint32_t>(address + length, video_memory_start + video_memory_length);
+    for (uint32_t a = start; a < end; ++a) {
+        mark_written(a);
+    }
+}
+
+void ULA::invalidate()
 {
-    pixels = std::vector<uint8_t>(Frontend::texture_width * Frontend::texture_height * Frontend::texture_bpp, 0);
+    for (uint64_t& captured : lines_captured) {
+        captured = 0;
+    }
+    charsets_captured = 0;
+    captures[capture_index].repaint = true;
+}
+
+void ULA::set_threaded(bool threaded)
+{
+    if (threaded == worker.joinable()) {
+        return;
+    }
+
+    if (threaded) {
+        stopping = false;
+        worker = std::thread(&ULA::paint_loop, this);
+    }
+    else {
+        wait_painted();
+        stopping = true;
+        frame_pending = true;
+        frame_pending.notify_one();
+        worker.join();
+        frame_pending = false;
+    }
+}
+
+void ULA::wait_painted()
+{
+    frame_pending.wait(true, std::memory_order_acquire);
 }
 
 
@@ -53,12 +190,14 @@ bool ULA::paint_raster()
 {
     bool render_screen = false;
 
-    if ((raster_current >= raster_visible_first) && (raster_current <= raster_visible_last)) {
-        update_graphics(raster_current - raster_visible_first);
+    if ((raster_current >= raster_visible_first) && (raster_current < raster_visible_last)) {
+        capture_line(raster_current - raster_visible_first);
     }
 
     if (++raster_current == raster_max) {
         raster_current = 0;
+
+        // Frames skipped in warp mode are captured on top of each other.
         if (machine->warpmode_on) {
             warpmode_counter = (warpmode_counter + 1) % 25;
             if (warpmode_counter) {
@@ -66,101 +205,268 @@ bool ULA::paint_raster()
             }
         }
 
+        if (! worker.joinable()) {
+            paint_frame(captures[capture_index]);
+        }
+        else if (! frame_pending.load(std::memory_order_acquire)) {
+            // Worker is done with the other capture, hand this one over. If the
+            // worker is still busy, the next frame is captured on top of this.
+            capture_index ^= 1;
+            frame_pending.store(true, std::memory_order_release);
+            frame_pending.notify_one();
+        }
+
         render_screen = true;
-        machine->frontend->render_graphics(pixels);
+        if (machine->frontend) {
+            machine->frontend->render_graphics(presented_frame());
+        }
         frame_count++;
     }
 
     return render_screen;
 }
 
-
-// Return memory address corresponding to a raster line, for current video mode.
-inline uint16_t calcRowAddr(uint8_t raster_line, uint8_t video_attrib)
+void ULA::capture_line(uint8_t raster_line)
 {
-    if (video_attrib & ULA::VideoAttribs::HIRES && raster_line < 200) {
-        return 0xa000 + raster_line * 40;			// Hires: return address for hires data for line.
+    FrameCapture& frame = captures[capture_index];
+    LineCapture& line = frame.lines[raster_line];
+    line.blink_shown = frame_count & 0x10;
+
+    uint64_t captured = lines_captured[raster_line];
+    uint8_t text_row = text_row_first + (raster_line >> 3);
+    if (captured && rows_written[text_row] <= captured && charsets_written <= captured &&
+        (raster_line >= 200 || rows_written[raster_line] <= captured)) {
+        return;
     }
-    return 0xbb80 + (raster_line >> 3) * 40;		// Text (lores or > 200): return address to char data for line (>>3).
-}
 
+    if (raster_line < 200) {
+        memcpy(line.rows[0], memory->mem + hires_start + raster_line * 40, 40);
+    }
+    memcpy(line.rows[1], memory->mem + hires_start + text_row * 40, 40);
 
-void ULA::update_graphics(uint8_t raster_line)
+    if (charsets_written > charsets_captured) {
+        // Copy only glyphs written since last copy.
+        for (uint8_t charset = 0; charset < 4; ++charset) {
+            if (charset_written[charset] > charsets_captured) {
+                uint16_t address = (charset < 2 ? hires_charset_start : text_charset_start - charset_length) +
+                                   charset * glyphs_length;
+                GlyphsCopy& copy = frame.charsets.emplace_back();
+                copy.charset = charset;
+                memcpy(copy.glyphs.data(), memory->mem + address, glyphs_length);
+            }
+        }
+        line.charsets = frame.charsets.size() - 1;
+        charsets_captured = write_serial;
+    }
+
+    line.fresh = true;
+    lines_captured[raster_line] = write_serial;
+}
+
+void ULA::paint_frame(FrameCapture& frame)
 {
-    uint32_t bg_col = colors[0];
-    uint32_t fg_col = colors[7];
-    text_attrib = 0;
-    blink = 0x3f;
-
-    uint32_t* texture_line = (uint32_t*) &pixels[raster_line * Frontend::texture_width * Frontend::texture_bpp];
-    uint16_t row = calcRowAddr(raster_line, video_attrib);
-
-    // 40 characters wide, regardless of lores or hires.
-    for (uint16_t x = 0; x < 40; x++) {
-        bool ctrl_char = false;
-
-        // get char code.
-        uint8_t ch = memory->mem[row + x];
-
-        if (!(ch & 0x60)) {
-            ctrl_char = true;
-            switch(ch & 0x18)
-            {
-                case 0x00:
-                    // Ink color.
-                    fg_col = colors[ch & 7];
-                    break;
-                case 0x08:
-                    // Text attributes.
-                    text_attrib = ch & 7;
-                    blink = ch & 0x04 ? 0x00 : 0x3f;
-                    break;
-                case 0x10:
-                    // Paper color.
-                    bg_col = colors[ch & 7];
-                    break;
-                case 0x18:
-                    // Video control attrs.
-                    video_attrib = ch & 0x07;
-                    row = calcRowAddr(raster_line, video_attrib);
-                    break;
+    ++paint_serial;
+
+    // Copies are taken in order, up to the last one of each line. Lines of a frame
+    // captured on top of an earlier one can refer to copies already taken.
+    int16_t charsets_taken = -1;
+
+    for (uint8_t raster_line = 0; raster_line < visible_lines; ++raster_line) {
+        LineCapture& capture = frame.lines[raster_line];
+        LineState& line = lines[raster_line];
+        bool changed = frame.repaint || ! line.painted || line.video_attrib_in != video_attrib ||
+                       (line.blinking && line.blink_shown != capture.blink_shown);
+
+        while (charsets_taken < capture.charsets) {
+            update_charsets(frame.charsets[++charsets_taken]);
+        }
+        capture.charsets = -1;
+        for (uint8_t charset = 0; charset < 4; ++charset) {
+            changed |= (line.charsets & (1 << charset)) && charsets_changed[charset] > line.painted;
+        }
+
+        if (capture.fresh) {
+            if (memcmp(line.rows, capture.rows, sizeof(line.rows))) {
+                memcpy(line.rows, capture.rows, sizeof(line.rows));
+                changed = true;
             }
+            capture.fresh = false;
         }
 
-        uint32_t _fg_col = fg_col;
-        uint32_t _bg_col = bg_col;
+        line.blink_shown = capture.blink_shown;
+        if (! changed) {
+            video_attrib = line.video_attrib_out;
+        }
+        else if (vector_paint) {
+            update_graphics<true>(raster_line);
+        }
+        else {
+            update_graphics<false>(raster_line);
+        }
+    }
+
+    frame.charsets.clear();
+    frame.repaint = false;
+}
+
+void ULA::update_charsets(const GlyphsCopy& copy)
+{
+    uint8_t* glyphs = charsets.data() + copy.charset * glyphs_length;
+    if (! memcmp(glyphs, copy.glyphs.data(), glyphs_length)) {
+        return;
+    }
+
+    // New serial, so lines painted earlier in this frame are painted again in the next.
+    charsets_changed[copy.charset] = ++paint_serial;
 
-        uint8_t mask = frame_count & 0x10 ? 0x3f : blink;
+    // Expand changed glyphs only.
+    uint64_t* masks = glyph_masks.data() + copy.charset * glyphs_length;
+    for (uint16_t glyph = 0; glyph < glyphs_length; glyph += 8) {
+        if (memcmp(glyphs + glyph, copy.glyphs.data() + glyph, 8)) {
+            memcpy(glyphs + glyph, copy.glyphs.data() + glyph, 8);
+            for (uint8_t row = 0; row < 8; ++row) {
+                memcpy(&masks[glyph + row], pattern_masks[glyphs[glyph + row] & 0x3f].data(), 8);
+            }
+        }
+    }
+}
 
-        // Inverse colors if upper bit is set in char code.
-        if (ch & 0x80) {
-            _fg_col = _fg_col ^ 0x00ffffff;
-            _bg_col = _bg_col ^ 0x00ffffff;
+void ULA::paint_loop()
+{
+    while (true) {
+        frame_pending.wait(false, std::memory_order_acquire);
+        if (stopping) {
+            return;
         }
 
-        uint8_t chr_dat = 0;
-        if (!ctrl_char) {
-            if ((video_attrib & VideoAttribs::HIRES) && raster_line < 200) {
-                chr_dat = ch & mask;	// Hires, read byte directly.
+        paint_frame(captures[capture_index ^ 1]);
+
+        // Publish painted frame, taking the previously published one as next back buffer.
+        std::copy(pixels.begin(), pixels.end(), frames[frame_back].begin());
+        frame_back = frame_ready.exchange(frame_back | frame_new, std::memory_order_acq_rel) & ~frame_new;
+
+        frame_pending.store(false, std::memory_order_release);
+        frame_pending.notify_all();
+    }
+}
+
+const std::vector<uint8_t>& ULA::presented_frame()
+{
+    if (! worker.joinable()) {
+        return pixels;
+    }
+
+    if (frame_ready.load(std::memory_order_acquire) & frame_new) {
+        frame_front = frame_ready.exchange(frame_front, std::memory_order_acq_rel) & ~frame_new;
+    }
+    return frames[frame_front];
+}
+
+
+// Return captured row shown on a raster line, for current video mode.
+inline const uint8_t* row_data(const uint8_t (&rows)[2][40], uint8_t raster_line, uint8_t video_attrib)
+{
+    if (video_attrib & ULA::VideoAttribs::HIRES && raster_line < 200) {
+        return rows[0];			// Hires: hires data for line.
+    }
+    return rows[1];				// Text (lores or > 200): char data for line (>>3).
+}
+
+
+void ULA::set_text_attrib(PaintState& state, uint8_t text_attrib)
+{
+    LineState& line = lines[state.raster_line];
+
+    state.mask = (text_attrib & TextAttribs::BLINKING ? 0x00 : 0x3f) | state.blink_shown;
+    state.glyph_mask = state.mask ? ~0ull : 0;
+    line.blinking |= text_attrib & TextAttribs::BLINKING;
+
+    // Glyph row for this raster line of character 0. If hires > 200, charmem is at 0x9800.
+    uint8_t charset = ((video_attrib & VideoAttribs::HIRES) ? 0 : 2) + (text_attrib & TextAttribs::ALTERNATE_CHARSET);
+    uint8_t apan = (text_attrib & TextAttribs::DOUBLE_SIZE) ? ((state.raster_line >> 1) & 0x07) : (state.raster_line & 0x07);
+    state.glyphs = charsets.data() + charset * 0x400 + apan;
+    state.glyph_masks = glyph_masks.data() + charset * 0x400 + apan;
+    state.text_attrib = text_attrib;
+    if (! state.hires) {
+        line.charsets |= 1 << charset;
+    }
+}
+
+template <bool Vector, bool Hires>
+uint8_t ULA::paint_cells(PaintState& state, uint8_t x)
+{
+    uint8_t* texture = &pixels[state.raster_line * Frontend::texture_width + x * 6];
+
+    for (; x < 40; ++x, texture += 6) {
+        uint8_t ch = state.row[x];
+
+        // Inverse colors if upper bit is set in char code, the inverse of color c is 7 - c.
+        uint8_t inverse = -(ch >> 7) & 7;
+
+        if (ch & 0x60) {
+            if constexpr (Vector && ! Hires) {
+                blend_cell(texture, state.glyph_masks[(ch & 0x7f) << 3] & state.glyph_mask,
+                           state.fg_col ^ inverse, state.bg_col ^ inverse);
             }
             else {
-                // get char pixel data for read char code. If hires > 200, charmem is at 0x9800.
-                uint8_t* char_mem = memory->mem + ((video_attrib & VideoAttribs::HIRES) ? 0x9800 : 0xb400) +
-                                    ((text_attrib & TextAttribs::ALTERNATE_CHARSET) ? 128 * 8 : 0);
-
-                uint8_t apan = (text_attrib & TextAttribs::DOUBLE_SIZE) ? ((raster_line >> 1) & 0x07) : (raster_line & 0x07);
-                chr_dat = char_mem[((ch & 0x7f) << 3) + apan] & mask;
+                uint8_t pattern = Hires ? ch & state.mask : state.glyphs[(ch & 0x7f) << 3] & state.mask;
+                paint_cell<Vector>(texture, pattern, state.fg_col ^ inverse, state.bg_col ^ inverse);
             }
+            continue;
         }
 
-        // Copy 6 pixels.
-        *texture_line++ = (chr_dat & 0x20) ? _fg_col : _bg_col;
-        *texture_line++ = (chr_dat & 0x10) ? _fg_col : _bg_col;
-        *texture_line++ = (chr_dat & 0x08) ? _fg_col : _bg_col;
-        *texture_line++ = (chr_dat & 0x04) ? _fg_col : _bg_col;
-        *texture_line++ = (chr_dat & 0x02) ? _fg_col : _bg_col;
-        *texture_line++ = (chr_dat & 0x01) ? _fg_col : _bg_col;
+        switch (ch & 0x18) {
+            case 0x00:
+                // Ink color.
+                state.fg_col = ch & 7;
+                break;
+            case 0x08:
+                // Text attributes.
+                set_text_attrib(state, ch & 7);
+                break;
+            case 0x10:
+                // Paper color.
+                state.bg_col = ch & 7;
+                break;
+            case 0x18:
+                // Video control attrs, continue in the renderer for the new mode.
+                video_attrib = ch & 0x07;
+                paint_cell<Vector>(texture, 0, state.fg_col ^ inverse, state.bg_col ^ inverse);
+                return x + 1;
+        }
+        paint_cell<Vector>(texture, 0, state.fg_col ^ inverse, state.bg_col ^ inverse);
     }
+    return x;
 }
 
+template <bool Vector>
+void ULA::update_graphics(uint8_t raster_line)
+{
+    LineState& line = lines[raster_line];
+    line.painted = paint_serial;
+    line.video_attrib_in = video_attrib;
+    line.charsets = 0;
+    line.blinking = false;
+
+    PaintState state;
+    state.raster_line = raster_line;
+    state.fg_col = 7;
+    state.bg_col = 0;
+
+    // Blinking characters are shown every other 16 frames.
+    state.blink_shown = line.blink_shown ? 0x3f : 0x00;
+
+    // 40 characters wide, regardless of lores or hires. Cells are painted in
+    // runs of the same video mode.
+    uint8_t text_attrib = 0;
+    for (uint8_t x = 0; x < 40; ) {
+        state.hires = (video_attrib & VideoAttribs::HIRES) && raster_line < 200;
+        state.row = row_data(line.rows, raster_line, video_attrib);
+        set_text_attrib(state, text_attrib);
 
+        x = state.hires ? paint_cells<Vector, true>(state, x) : paint_cells<Vector, false>(state, x);
+        text_attrib = state.text_attrib;
+    }
+
+    line.video_attrib_out = video_attrib;
+}
@@ -18,10 +18,14 @@
 #ifndef ULA_H
 #define ULA_H
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "frontend.hpp"
 #include "machine.hpp"
@@ -31,9 +35,11 @@ class ULA
 {
 public:
     /**
-     * Oric color palette from color index.
+     * Oric color palette from color index, in texture format. Pixels are painted
+     * as color indexes and converted when the frame is presented.
      */
-    uint32_t colors[8] {0xff000000, 0xffff0000, 0xff00ff00, 0xffffff00, 0xff0000ff, 0xffff00ff, 0xff00ffff, 0xffffffff};
+    static constexpr uint32_t colors[8] {0xff000000, 0xffff0000, 0xff00ff00, 0xffffff00,
+                                         0xff0000ff, 0xffff00ff, 0xff00ffff, 0xffffffff};
 
     enum VideoAttribs
     {
@@ -48,21 +54,208 @@ public:
         BLINKING = 0x04,
     };
 
+    // Memory the ULA reads: hires charsets, hires screen, text charsets and text screen.
+    static constexpr uint16_t video_memory_start = 0x9800;
+    static constexpr uint16_t video_memory_length = 0x2800;
+
+    static constexpr uint16_t visible_lines = 224;
+
     ULA(Machine* machine, Memory* memory, uint8_t texture_width, uint8_t texture_height, uint8_t texture_bpp);
+    ~ULA();
 
     /**
-     * Paint one raster line.
+     * Capture memory shown on one raster line. Lines are painted from the
+     * captures when the frame is finished, on a worker thread if threaded.
      * @return true if screen is finished and should be rendered.
      */
     bool paint_raster();
 
+    /**
+     * Get painted pixels. If threaded, call wait_painted() first.
+     * @return color index of each pixel of all raster lines, see colors
+     */
+    const std::vector<uint8_t>& get_pixels() { return pixels; }
+
+    /**
+     * Paint finished frames on a worker thread instead of in paint_raster().
+     * @param threaded true to start worker thread, false to stop it
+     */
+    void set_threaded(bool threaded);
+
+    /**
+     * Wait until the worker thread has painted all finished frames.
+     */
+    void wait_painted();
+
+    /**
+     * Select how character cells are painted, for comparing speed.
+     * @param vector true to blend all pixels of a cell in one 64 bit word, false for plain selects
+     */
+    void set_vector_paint(bool vector) { vector_paint = vector; }
+
+    /**
+     * Note write to video memory, so raster lines showing it are painted again.
+     * @param address written address, in video memory
+     */
+    void mark_written(uint16_t address)
+    {
+        ++write_serial;
+        if (address >= hires_start) {
+            rows_written[(address - hires_start) / 40] = write_serial;
+        }
+        if (address < hires_start) {
+            charsets_written = charset_written[(address - hires_charset_start) / glyphs_length] = write_serial;
+        }
+        else if ((uint16_t)(address - text_charset_start) < charset_length) {
+            charsets_written = charset_written[2 + (address - text_charset_start) / glyphs_length] = write_serial;
+        }
+    }
+
+    /**
+     * Note write to a memory range, so raster lines showing any part of it are painted again.
+     * @param address start address
+     * @param length number of bytes written
+     */
+    void mark_written(uint16_t address, uint32_t length);
+
+    /**
+     * Paint all raster lines again, after memory was changed without being marked.
+     */
+    void invalidate();
+
 private:
+    static constexpr uint16_t hires_start = 0xa000;
+    static constexpr uint16_t hires_charset_start = 0x9800;
+    static constexpr uint16_t text_charset_start = 0xb400;
+    static constexpr uint16_t charset_length = 0x800;
+    static constexpr uint16_t glyphs_length = 0x400;    // Standard or alternate half of a charset.
+    static constexpr uint16_t text_row_first = (0xbb80 - hires_start) / 40;
+
+    // Hires charsets followed by text charsets, standard and alternate in each.
+    typedef std::array<uint8_t, 2 * charset_length> Charsets;
+
+    // Pixel mask of each glyph row in Charsets, at the same index, 0xff in the
+    // bytes of the foreground pixels.
+    typedef std::array<uint64_t, 2 * charset_length> GlyphMasks;
+
+    /**
+     * Glyphs of a standard or alternate charset, captured after being written.
+     */
+    struct GlyphsCopy
+    {
+        uint8_t charset;            // Index of the 1 KB glyphs in Charsets, as charsets_changed.
+        std::array<uint8_t, glyphs_length> glyphs;
+    };
+
+    /**
+     * Memory shown on a raster line, captured when the line is displayed.
+     */
+    struct LineCapture
+    {
+        bool fresh;                 // Rows captured since frame was painted.
+        bool blink_shown;           // Blinking characters shown in this frame.
+        int16_t charsets;           // Last copy in FrameCapture::charsets to use from this line, or -1.
+        uint8_t rows[2][40];        // Hires row, text row. The video mode can change within the line.
+    };
+
+    /**
+     * Captured lines of a frame. If a frame is not painted, the next frame is
+     * captured on top of it.
+     */
+    struct FrameCapture
+    {
+        LineCapture lines[visible_lines];
+        std::vector<GlyphsCopy> charsets;  // Cleared when painted, keeping its storage.
+        bool repaint;               // Paint all lines, also unchanged.
+    };
+
+    /**
+     * What a raster line was painted from, to tell if it must be painted again.
+     */
+    struct LineState
+    {
+        uint64_t painted;           // paint_serial when painted, 0 if not painted.
+        uint8_t video_attrib_in;    // Carried from previous line.
+        uint8_t video_attrib_out;   // Carried to next line.
+        uint8_t charsets;           // Bit per 1 KB charset read, as charsets_changed.
+        bool blinking;              // Has blinking attribute, changes with blink phase.
+        bool blink_shown;
+        uint8_t rows[2][40];
+    };
+
+    /**
+     * Capture memory shown on a raster line into the frame being captured, if written since last capture.
+     * @param raster_line raster line to capture
+     */
+    void capture_line(uint8_t raster_line);
+
+    /**
+     * Paint changed lines of a captured frame.
+     * @param frame captured frame, marked as painted
+     */
+    void paint_frame(FrameCapture& frame);
+
+    /**
+     * Take glyphs captured from memory, expanding changed glyphs into glyph_masks.
+     * @param copy captured glyphs
+     */
+    void update_charsets(const GlyphsCopy& copy);
+
+    /**
+     * State while painting a raster line.
+     */
+    struct PaintState
+    {
+        uint8_t raster_line;
+        const uint8_t* row;         // Captured row for current video mode.
+        const uint8_t* glyphs;      // Glyph row for raster line of character 0, in charsets.
+        const uint64_t* glyph_masks;    // Same glyph row in glyph_masks.
+        bool hires;                 // Row is hires data.
+        uint8_t text_attrib;
+        uint8_t fg_col;
+        uint8_t bg_col;
+        uint8_t blink_shown;        // 0x3f if blinking characters are shown.
+        uint8_t mask;               // Pattern mask, 0x00 for hidden blinking characters.
+        uint64_t glyph_mask;        // Same for glyph_masks.
+    };
+
+    /**
+     * Set text attributes, selecting glyph row and blink mask.
+     * @param state paint state to update
+     * @param text_attrib new text attributes
+     */
+    void set_text_attrib(PaintState& state, uint8_t text_attrib);
+
+    /**
+     * Paint character cells of a raster line until the video mode changes.
+     * @tparam Vector true to paint character cells in one 64 bit word
+     * @tparam Hires true if row is hires data, false for characters
+     * @param state paint state
+     * @param x first cell to paint
+     * @return cell after last painted cell, 40 at end of line
+     */
+    template <bool Vector, bool Hires>
+    uint8_t paint_cells(PaintState& state, uint8_t x);
+
     /**
-     * Update graphics for given raster line.
-     * @param raster_line raster line to update
+     * Paint given raster line.
+     * @tparam Vector true to paint character cells in one 64 bit word
+     * @param raster_line raster line to paint
      */
+    template <bool Vector>
     void update_graphics(uint8_t raster_line);
 
+    /**
+     * Paint frames handed over by paint_raster() until stopped.
+     */
+    void paint_loop();
+
+    /**
+     * Get frame to present.
+     * @return latest painted frame
+     */
+    const std::vector<uint8_t>& presented_frame();
+
     Machine* machine;
     Memory* memory;
 
@@ -70,16 +263,43 @@ private:
     uint8_t texture_height;
     uint8_t texture_bpp;
 
-    uint8_t video_attrib;
-    uint8_t text_attrib;
-
     uint16_t raster_current;
     uint8_t warpmode_counter;
-
-    uint8_t blink;
     uint32_t frame_count;
 
+    // Emulation thread: serial of last write to each 40 byte row from $a000,
+    // to any charset and to each 1 KB of glyphs, and of the capture of each line.
+    uint64_t write_serial;
+    uint64_t rows_written[(video_memory_start + video_memory_length - hires_start + 39) / 40];
+    uint64_t charsets_written;
+    uint64_t charset_written[4];
+    uint64_t charsets_captured;
+    uint64_t lines_captured[visible_lines];
+
+    // Frame being captured and frame handed to worker thread.
+    FrameCapture captures[2];
+    uint8_t capture_index;
+
+    // Painting, done by the worker thread if threaded.
+    uint8_t video_attrib;
+    uint64_t paint_serial;          // Advanced for each painted frame and each charset change.
+    uint64_t charsets_changed[4];
+    Charsets charsets;
+    GlyphMasks glyph_masks;
+    LineState lines[visible_lines];
     std::vector<uint8_t> pixels;
+    bool vector_paint;
+
+    // Worker thread. A frame is handed over by setting frame_pending, and
+    // painted frames are passed back in a triple buffer.
+    std::thread worker;
+    std::atomic<bool> frame_pending;
+    std::atomic<bool> stopping;
+    std::vector<uint8_t> frames[3];
+    uint8_t frame_back;
+    uint8_t frame_front;
+    std::atomic<uint8_t> frame_ready;   // Index of latest painted frame, frame_new if not presented.
+    static constexpr uint8_t frame_new = 0x04;
 };
 
 
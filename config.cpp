@@ -35,7 +35,10 @@ namespace po = boost::program_options;
 
 Config::Config() :
     _start_in_monitor(false),
-    _use_atmos_rom(false)
+    _use_atmos_rom(false),
+    _cycle_exact(false),
+    _hle(false),
+    _band_limited(false)
 {
 }
 
@@ -49,7 +52,10 @@ bool Config::parse(int argc, char **argv)
             ("help,?", "produce help message")
             ("monitor,m", po::bool_switch(&_start_in_monitor), "start in monitor mode")
             ("atmos,a", po::bool_switch(&_use_atmos_rom), "use Atmos ROM")
-            ("tape,t", po::value<std::filesystem::path>(&_tape_path), "Tape file to use");
+            ("tape,t", po::value<std::filesystem::path>(&_tape_path), "Tape file to use")
+            ("cycle-exact,c", po::bool_switch(&_cycle_exact), "step all chips every clock cycle instead of per instruction")
+            ("hle", po::bool_switch(&_hle), "run known BASIC ROM routines natively (not with --cycle-exact)")
+            ("band-limited", po::bool_switch(&_band_limited), "synthesize sound band-limited instead of point sampled");
 
         po::variables_map vm;
         po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
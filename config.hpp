@@ -56,9 +56,30 @@ public:
      */
     bool use_atmos_rom() { return _use_atmos_rom; }
 
+    /**
+     * Check if emulation should step all chips every clock cycle.
+     * @return true if emulation should be cycle exact
+     */
+    bool cycle_exact() { return _cycle_exact; }
+
+    /**
+     * Check if known ROM routines should run natively, see Hle.
+     * @return true if high level emulation is enabled
+     */
+    bool hle() { return _hle; }
+
+    /**
+     * Check if sound should be synthesized band-limited, see AY3_8912::set_band_limited().
+     * @return true if sound is band-limited
+     */
+    bool band_limited() { return _band_limited; }
+
 protected:
     bool _start_in_monitor;
     bool _use_atmos_rom;
+    bool _cycle_exact;
+    bool _hle;
+    bool _band_limited;
     std::filesystem::path _tape_path;
 };
 
@@ -242,9 +242,21 @@ bool Frontend::handle_frame()
     return true;
 }
 
-void Frontend::render_graphics(std::vector<uint8_t>& pixels)
+void Frontend::render_graphics(const std::vector<uint8_t>& pixels)
 {
-    SDL_UpdateTexture(sdl_texture, NULL, &pixels[0], texture_width * texture_bpp);
+    void* texture_data;
+    int pitch;
+    if (SDL_LockTexture(sdl_texture, NULL, &texture_data, &pitch) == 0) {
+        // Locked texture is write only, so all lines are converted.
+        for (uint32_t y = 0; y < texture_height; ++y) {
+            const uint8_t* source = &pixels[y * texture_width];
+            uint32_t* target = (uint32_t*)((uint8_t*)texture_data + y * pitch);
+            for (uint32_t x = 0; x < texture_width; ++x) {
+                target[x] = ULA::colors[source[x] & 7];
+            }
+        }
+        SDL_UnlockTexture(sdl_texture);
+    }
     SDL_RenderCopy(sdl_renderer, sdl_texture, NULL, NULL );
     SDL_RenderPresent(sdl_renderer);
 }
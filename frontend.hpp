@@ -104,10 +104,10 @@ public:
     bool handle_frame();
 
     /**
-     * Render graphics.
-     * @param pixels refernce to pixels to render
+     * Render graphics, converting pixels directly into the locked texture.
+     * @param pixels color index of each pixel, see ULA::colors
      */
-    void render_graphics(std::vector<uint8_t>& pixels);
+    void render_graphics(const std::vector<uint8_t>& pixels);
 
 protected:
     Oric* oric;
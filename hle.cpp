@@ -0,0 +1,191 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include <cstring>
+
+#include "hle.hpp"
+#include "machine.hpp"
+
+
+const std::vector<Hle::Rom> Hle::roms = {
+    {basic10_crc, "BASIC 1.0", {
+        {0xf6da, &Hle::clear_line}
+    }},
+    {basic11b_crc, "BASIC 1.1", {
+        {0xedc4, &Hle::block_move},
+        {0xf71a, &Hle::clear_line}
+    }}
+};
+
+
+Hle::Hle(Memory& memory, ULA& ula) :
+    memory(memory),
+    ula(ula),
+    attached(nullptr)
+{
+}
+
+uint32_t Hle::crc32(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+const char* Hle::attach(MOS6502<OricBus>& cpu, uint32_t rom_crc)
+{
+    detach(cpu);
+
+    for (const Rom& rom : roms) {
+        if (rom.crc == rom_crc) {
+            attached = &rom;
+            for (const Routine& routine : rom.routines) {
+                cpu.set_trap(routine.address, true);
+            }
+            return rom.name;
+        }
+    }
+    return nullptr;
+}
+
+void Hle::detach(MOS6502<OricBus>& cpu)
+{
+    if (attached) {
+        for (const Routine& routine : attached->routines) {
+            cpu.set_trap(routine.address, false);
+        }
+        attached = nullptr;
+    }
+}
+
+uint32_t Hle::run(MOS6502<OricBus>& cpu, uint16_t address)
+{
+    // Zero page, stack and BASIC variables in page 2 are accessed directly by all routines,
+    // and the ROM itself must not be switched out by an overlay.
+    if (! attached || ! is_direct(0x0000, 0x0300, true) || ! is_direct(address, 1, false)) {
+        return 0;
+    }
+
+    for (const Routine& routine : attached->routines) {
+        if (routine.address == address) {
+            return (this->*routine.run)(cpu);
+        }
+    }
+    return 0;
+}
+
+bool Hle::is_direct(uint32_t address, uint32_t length, bool write)
+{
+    if (address + length > 0x10000) {
+        return false;
+    }
+
+    for (uint32_t page = address >> 8; page << 8 < address + length; ++page) {
+        uint8_t* data = memory.mem + (page << 8);
+        if (memory.read_pages[page] != data || (write && memory.write_pages[page] != data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Set registers after a routine and return from it like RTS.
+ * @param cpu CPU to return in
+ * @param registers registers at end of routine, before RTS
+ * @param memory memory with stack
+ */
+static void return_from_subroutine(MOS6502<OricBus>& cpu, MOS6502<OricBus>::Registers registers, Memory& memory)
+{
+    uint8_t low = memory.mem[STACK_BOTTOM | ++registers.sp];
+    uint8_t high = memory.mem[STACK_BOTTOM | ++registers.sp];
+    registers.pc = (low | high << 8) + 1;
+    cpu.set_registers(registers);
+}
+
+uint32_t Hle::block_move(MOS6502<OricBus>& cpu)
+{
+    uint8_t* zp = memory.mem;
+    uint16_t source = zp[0x0c] | zp[0x0d] << 8;
+    uint16_t target = zp[0x0e] | zp[0x0f] << 8;
+    uint8_t length_low = zp[0x10];
+    uint8_t pages = zp[0x11];
+    uint32_t length = pages << 8 | length_low;
+
+    if (! is_direct(source, length, false) || ! is_direct(target, length, true)) {
+        return 0;
+    }
+
+    if (target > source && target < source + length) {
+        // Forward copy into itself repeats the first bytes, as the ROM loop does.
+        for (uint32_t i = 0; i < length; ++i) {
+            memory.mem[target + i] = memory.mem[source + i];
+        }
+    }
+    else {
+        memmove(memory.mem + target, memory.mem + source, length);
+    }
+    ula.mark_written(target, length);
+
+    MOS6502<OricBus>::Registers registers = cpu.get_registers();
+    if (length) {
+        registers.a = memory.mem[target + length - 1];
+    }
+    registers.x = pages;
+    registers.y = length_low;
+    registers.p = (registers.p & ~FLAG_N) | FLAG_Z | FLAG_C;   // From final CPX $11.
+    zp[0x0d] += pages;
+    zp[0x0f] += pages;
+    return_from_subroutine(cpu, registers, memory);
+
+    // LDA ($0c),Y takes an extra cycle for each byte where the source crosses a page.
+    uint8_t source_low = zp[0x0c];
+    uint32_t crossings = pages * source_low;
+    if (source_low && length_low > 0x100 - source_low) {
+        crossings += length_low - (0x100 - source_low);
+    }
+
+    // LDY and final compares with RTS, 22 cycles per byte and 18 per page.
+    return 19 + 22 * length + 18 * pages + crossings;
+}
+
+uint32_t Hle::clear_line(MOS6502<OricBus>& cpu)
+{
+    uint16_t line = memory.mem[0x12] | memory.mem[0x13] << 8;
+    if (! is_direct(line, 40, true)) {
+        return 0;
+    }
+
+    memset(memory.mem + line, ' ', 40);
+    memory.mem[line] = memory.mem[0x026b];
+    memory.mem[line + 1] = memory.mem[0x026c];
+    ula.mark_written(line, 40);
+
+    MOS6502<OricBus>::Registers registers = cpu.get_registers();
+    registers.a = memory.mem[0x026c];
+    registers.y = 1;
+    registers.p &= ~(FLAG_N | FLAG_Z);    // From final INY.
+    return_from_subroutine(cpu, registers, memory);
+
+    // LDA #, 40 times STA/DEY/BPL, attribute bytes and RTS.
+    return 2 + 40 * 11 - 1 + 30;
+}
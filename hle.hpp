@@ -0,0 +1,130 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// High level emulation of hot BASIC ROM routines. The CPU traps the entry
+// point of each known routine and the routine is run natively instead, with
+// the same result in registers and memory and the same cycle count as when
+// run on the CPU.
+
+#ifndef HLE_H
+#define HLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "memory.hpp"
+
+class OricBus;
+class ULA;
+template <typename Bus> class MOS6502;
+
+
+class Hle
+{
+public:
+    static constexpr uint32_t basic10_crc = 0xf18710b4;
+    static constexpr uint32_t basic11b_crc = 0xc3a92bef;
+
+    /**
+     * Create high level emulation.
+     * @param memory memory routines run in
+     * @param ula ULA to tell about written video memory
+     */
+    Hle(Memory& memory, ULA& ula);
+
+    /**
+     * Calculate CRC-32 of data, as used to identify ROMs.
+     * @param data data to checksum
+     * @param length number of bytes
+     * @return CRC-32 of data
+     */
+    static uint32_t crc32(const uint8_t* data, size_t length);
+
+    /**
+     * Set CPU traps for the known routines of a ROM, removing any previous traps.
+     * @param cpu CPU to set traps in
+     * @param rom_crc CRC-32 of the 16 KB ROM at $c000
+     * @return name of ROM, or nullptr if ROM is unknown
+     */
+    const char* attach(MOS6502<OricBus>& cpu, uint32_t rom_crc);
+
+    /**
+     * Remove all traps set by attach().
+     * @param cpu CPU to remove traps from
+     */
+    void detach(MOS6502<OricBus>& cpu);
+
+    /**
+     * Run trapped routine natively, returning from it as its RTS does.
+     * @param cpu CPU at the routine entry
+     * @param address trapped address
+     * @return cycles used by the routine after its first instruction, which
+     *         the CPU has already counted, or 0 to run the routine on the CPU
+     */
+    uint32_t run(MOS6502<OricBus>& cpu, uint16_t address);
+
+protected:
+    typedef uint32_t (Hle::*f_routine)(MOS6502<OricBus>& cpu);
+
+    struct Routine
+    {
+        uint16_t address;
+        f_routine run;
+    };
+
+    struct Rom
+    {
+        uint32_t crc;
+        const char* name;
+        std::vector<Routine> routines;
+    };
+
+    /**
+     * Check if a range is plain RAM (or ROM for reads) in the memory page tables.
+     * @param address start address
+     * @param length number of bytes
+     * @param write true if range is written
+     * @return true if range can be accessed directly in Memory::mem
+     */
+    bool is_direct(uint32_t address, uint32_t length, bool write);
+
+    /**
+     * Copy ($10/$11) bytes forward from ($0c) to ($0e), one page per X.
+     * BASIC 1.1 $EDC4, used for screen scrolling.
+     * @param cpu CPU at routine entry
+     * @return cycles after entry instruction, or 0 if not handled
+     */
+    uint32_t block_move(MOS6502<OricBus>& cpu);
+
+    /**
+     * Fill 40 byte text line at ($12) with spaces and set its two attribute
+     * bytes from $026b and $026c. BASIC 1.1 $F71A and BASIC 1.0 $F6DA, used by
+     * CLS and scrolling.
+     * @param cpu CPU at routine entry
+     * @return cycles after entry instruction, or 0 if not handled
+     */
+    uint32_t clear_line(MOS6502<OricBus>& cpu);
+
+    Memory& memory;
+    ULA& ula;
+
+    static const std::vector<Rom> roms;
+    const Rom* attached;
+};
+
+#endif // HLE_H
@@ -15,6 +15,7 @@
 //   along with this program.  If not, see <http://www.gnu.org/licenses/>
 // =========================================================================
 
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <thread>
@@ -48,14 +49,23 @@ constexpr uint32_t sound_pause_target = 1000;
 
 
 Machine::Machine(Oric* oric) :
+    break_exec(false),
+    memory(65536),
+    warpmode_on(false),
+    cycle_exact(oric->get_config().cycle_exact()),
     ula(this, &memory, Frontend::texture_width, Frontend::texture_height, Frontend::texture_bpp),
     oric(oric),
-    memory(65535),
     tape(nullptr),
-    cycle_count(0),
+    trace(scheduler.cycle),
+    hle(memory, ula),
+    hle_enabled(false),
+    device_cycle(0),
     next_frame(0),
-    warpmode_on(false),
-    break_exec(false),
+    idle_count(0),
+    idle_period(0),
+    idle_loop_cycles(0),
+    idle_probe_countdown(idle_probe_interval),
+    idle_probing(false),
     sound_paused(true),
     sound_pause_counter(0),
     current_key_row(0)
@@ -63,6 +73,10 @@ Machine::Machine(Oric* oric) :
     for (uint8_t i=0; i < 8; i++) {
         key_rows[i] = 0;
     }
+
+    // RAM everywhere, VIA at page 3 and ROM from $c000.
+    memory.map_io(0x0300, 0x100);
+    memory.map_write_ignore(0xc000, 0x4000);
 }
 
 Machine::~Machine()
@@ -71,21 +85,21 @@ Machine::~Machine()
 void Machine::init(Frontend* frontend)
 {
     this->frontend = frontend;
+    if (frontend && std::thread::hardware_concurrency() > 1) {
+        // Paint frames off the emulation thread.
+        ula.set_threaded(true);
+    }
     init_cpu();
     init_mos6522();
     init_ay3();
     init_tape();
+
+    scheduler.schedule(Scheduler::EVENT_RASTER, cycles_per_raster);
 }
 
 void Machine::init_cpu()
 {
-    cpu = new MOS6502(*this);
-    cpu->memory_read_byte_handler = read_byte;
-    cpu->memory_read_byte_zp_handler = read_byte_zp;
-    cpu->memory_read_word_handler = read_word;
-    cpu->memory_read_word_zp_handler = read_word_zp;
-    cpu->memory_write_byte_handler = write_byte;
-    cpu->memory_write_byte_zp_handler = write_byte_zp;
+    cpu = new MOS6502<OricBus>(OricBus(*this));
 }
 
 void Machine::init_mos6522()
@@ -114,6 +128,7 @@ void Machine::init_mos6522()
 void Machine::init_ay3()
 {
     ay3 = new AY3_8912(*this);
+    ay3->set_band_limited(oric->get_config().band_limited());
 
     // AY data bus reads from VIA ORA (Output Register A).
     ay3->m_read_data_handler = read_via_ora;
@@ -142,46 +157,20 @@ void Machine::reset()
 
 void Machine::run(Oric* oric)
 {
-    uint32_t instructions = 0;
-
     struct timeval tv;
     gettimeofday(&tv, NULL);
     next_frame = tv.tv_sec * 1000000 + tv.tv_usec;
 
     break_exec = false;
-    uint8_t ran = 0;
-
-    cycle_count += cycles_per_raster;
+    forget_idle_loop();
+    cpu->set_trap_handler(hle_enabled && ! cpu->is_debugging() ? trap_callback : nullptr);
 
     while (! break_exec) {
-        if (sound_paused) {
-            sound_pause_counter += 1;
-
-            if (sound_pause_counter > sound_pause_target) {
-                sound_paused = false;
-                frontend->pause_sound(false);
-            }
-        }
-
-        while (cycle_count > 0) {
-            tape->exec();
-            mos_6522->exec();
-            ay3->exec();
-
-            if (cpu->exec(break_exec)) {
-                update_key_output();
-//                frontend->unlock_audio();
-            }
-
-            if (break_exec) {
-                oric->do_break();
-                return;
-            }
-
-            --cycle_count;
+        if (! run_to_event(oric)) {
+            return;
         }
 
-        if (ula.paint_raster()) {
+        if (handle_events()) {
             next_frame += 20000;
 
             if (! frontend->handle_frame()) {
@@ -199,8 +188,323 @@ void Machine::run(Oric* oric)
                 }
             }
         }
+    }
+}
+
+bool Machine::run_for(uint64_t cycles, Oric* oric)
+{
+    uint64_t end = scheduler.cycle + cycles;
+    forget_idle_loop();
+    cpu->set_trap_handler(hle_enabled && ! cpu->is_debugging() ? trap_callback : nullptr);
+
+    while (scheduler.cycle < end) {
+        if (! run_to_event(oric)) {
+            return false;
+        }
+        handle_events();
+    }
+    return true;
+}
+
+bool Machine::run_to_event(Oric* oric)
+{
+    if (cpu->is_debugging()) {
+        forget_idle_loop();
+        return cycle_exact ? run_cycles<true>(oric) : run_instructions<true>(oric);
+    }
+    if (cycle_exact) {
+        return run_cycles<false>(oric);
+    }
+
+    if (idle_period && skip_idle_loop()) {
+        return true;
+    }
+    if (idle_probing || --idle_probe_countdown == 0) {
+        return probe_idle_loop(oric);
+    }
+    return run_instructions<false>(oric);
+}
+
+template <bool Debug>
+bool Machine::run_cycles(Oric* oric)
+{
+    while (scheduler.cycle < scheduler.next_event_cycle()) {
+        tape->exec();
+        mos_6522->exec();
+        ay3->exec();
+
+        if (cpu->template exec<Debug, true>(break_exec)) {
+            update_key_output();
+//                frontend->unlock_audio();
+        }
+
+        device_cycle = ++scheduler.cycle;
+
+        if (break_exec) {
+            oric->do_break();
+            return false;
+        }
+    }
+    return true;
+}
+
+template <bool Debug>
+bool Machine::run_instructions(Oric* oric)
+{
+    while (scheduler.cycle < scheduler.next_event_cycle()) {
+        scheduler.cycle += cpu->exec_instruction<Debug>(break_exec);
 
-        cycle_count += cycles_per_raster;
+        if (break_exec) {
+            oric->do_break();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Machine::probe_idle_loop(Oric* oric)
+{
+    if (! idle_probing) {
+        idle_probing = true;
+        idle_count = 0;
+        idle_probe_countdown = idle_probe_interval;
+    }
+
+    while (scheduler.cycle < scheduler.next_event_cycle()) {
+        if (idle_count == idle_probe_length || cpu->is_interrupt_pending() || ! cpu->is_idle_instruction()) {
+            idle_probing = false;
+            return run_instructions<false>(oric);
+        }
+
+        idle_states[idle_count] = cpu->get_registers();
+        idle_cycles[idle_count] = cpu->exec_instruction(break_exec);
+        scheduler.cycle += idle_cycles[idle_count++];
+
+        if (break_exec) {
+            idle_probing = false;
+            oric->do_break();
+            return false;
+        }
+
+        // Look for a period p where the last p instructions repeat the p before them.
+        // Only instructions without side effects were run, so memory read by the
+        // second iteration is the same for all following iterations.
+        MOS6502<OricBus>::Registers registers = cpu->get_registers();
+        for (uint32_t p = 1; p <= idle_max_period && 2 * p <= idle_count; ++p) {
+            uint32_t first = idle_count - 2 * p;
+            if (idle_states[first + p] != registers) {
+                continue;
+            }
+
+            uint32_t i = 0;
+            while (i < p && idle_states[first + i] == idle_states[first + p + i] &&
+                   idle_cycles[first + i] == idle_cycles[first + p + i]) {
+                ++i;
+            }
+            if (i < p) {
+                continue;
+            }
+
+            idle_loop_cycles = 0;
+            for (i = 0; i < p; ++i) {
+                idle_states[i] = idle_states[first + p + i];
+                idle_cycles[i] = idle_cycles[first + p + i];
+                idle_loop_cycles += idle_cycles[i];
+            }
+            idle_period = p;
+            idle_probing = false;
+            skip_idle_loop();
+            return true;
+        }
+    }
+    return true;
+}
+
+bool Machine::skip_idle_loop()
+{
+    MOS6502<OricBus>::Registers registers = cpu->get_registers();
+
+    uint32_t i = 0;
+    while (i < idle_period && idle_states[i] != registers) {
+        ++i;
+    }
+    if (i == idle_period || cpu->is_interrupt_pending()) {
+        // Left the loop, or about to. Whatever runs next may change memory it reads.
+        forget_idle_loop();
+        return false;
+    }
+
+    uint64_t next_event = scheduler.next_event_cycle();
+    if (scheduler.cycle >= next_event) {
+        return true;
+    }
+
+    uint64_t iterations = (next_event - scheduler.cycle) / idle_loop_cycles;
+    scheduler.cycle += iterations * idle_loop_cycles;
+    cpu->instruction_count += iterations * idle_period;
+
+    while (scheduler.cycle < next_event) {
+        scheduler.cycle += idle_cycles[i];
+        ++cpu->instruction_count;
+        if (++i == idle_period) {
+            i = 0;
+        }
+    }
+
+    cpu->set_registers(idle_states[i]);
+    return true;
+}
+
+void Machine::forget_idle_loop()
+{
+    idle_period = 0;
+    idle_probing = false;
+}
+
+bool Machine::enable_hle()
+{
+    return enable_hle(Hle::crc32(memory.mem + 0xc000, 0x4000));
+}
+
+bool Machine::enable_hle(uint32_t rom_crc)
+{
+    if (cycle_exact) {
+        std::cout << "HLE is not available in cycle exact mode." << std::endl;
+        return false;
+    }
+
+    const char* name = hle.attach(*cpu, rom_crc);
+    if (! name) {
+        std::cout << "HLE: unknown ROM (CRC " << std::hex << rom_crc << std::dec << "), not enabled." << std::endl;
+        return false;
+    }
+
+    // Trap handler is also updated when running, so debugging sees every instruction.
+    hle_enabled = true;
+    cpu->set_trap_handler(trap_callback);
+    std::cout << "HLE: enabled for " << name << "." << std::endl;
+    return true;
+}
+
+bool Machine::run_trap(uint16_t address)
+{
+    // First instruction of the routine is counted by the CPU. Long routines
+    // make the next event late, like a very long instruction would.
+    uint32_t cycles = hle.run(*cpu, address);
+    scheduler.cycle += cycles;
+    return cycles != 0;
+}
+
+bool Machine::handle_events()
+{
+    bool frame_done = false;
+
+    sync_devices(scheduler.cycle);
+
+    Scheduler::Event event;
+    uint64_t at;
+    while (scheduler.pop_due(event, at)) {
+        switch (event) {
+            case Scheduler::EVENT_RASTER:
+                scheduler.schedule(Scheduler::EVENT_RASTER, at + cycles_per_raster);
+
+                if (sound_paused && ++sound_pause_counter > sound_pause_target) {
+                    sound_paused = false;
+                    if (frontend) {
+                        frontend->pause_sound(false);
+                    }
+                }
+
+                frame_done |= ula.paint_raster();
+                break;
+
+            case Scheduler::EVENT_VIA:
+            case Scheduler::EVENT_TAPE:
+                // Already caught up by sync_devices, rescheduled below.
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    schedule_devices();
+    return frame_done;
+}
+
+uint8_t Machine::read_io(uint16_t address)
+{
+    uint8_t value;
+
+    if (const uint8_t* page = memory.mapped_read_pages[address >> 8]) {
+        // RAM or ROM page with watchpoints.
+        value = page[address & 0xff];
+    }
+    else {
+        // Only I/O on a plain Oric is the VIA at page 3.
+        sync_devices_to_access();
+        update_key_output();
+        value = mos_6522->read_byte(address);
+        schedule_devices();
+    }
+
+    if (cpu->breakpoints.is_read_watched(address)) {
+        cpu->breakpoints.trigger_watch(address, value, false);
+    }
+    return value;
+}
+
+void Machine::write_io(uint16_t address, uint8_t val)
+{
+    if (uint8_t* page = memory.mapped_write_pages[address >> 8]) {
+        // RAM or ROM page with watchpoints.
+        page[address & 0xff] = val;
+        ula.mark_written(address, 1);
+    }
+    else {
+        sync_devices_to_access();
+        mos_6522->write_byte(address, val);
+        schedule_devices();
+    }
+
+    if (cpu->breakpoints.is_write_watched(address)) {
+        cpu->breakpoints.trigger_watch(address, val, true);
+    }
+}
+
+void Machine::sync_devices(uint64_t cycle)
+{
+    while (device_cycle < cycle) {
+        // Step up to tape edges, so the VIA sees CB1 change at the right time.
+        uint32_t cycles = std::min<uint64_t>(cycle - device_cycle, tape->cycles_to_next_edge());
+
+        tape->exec(cycles);
+        mos_6522->exec(cycles);
+        ay3->exec(cycles);
+
+        device_cycle += cycles;
+    }
+}
+
+void Machine::schedule_devices()
+{
+    // In cycle exact mode all chips are stepped every cycle anyway.
+    if (cycle_exact) {
+        return;
+    }
+
+    if (uint32_t cycles = mos_6522->cycles_to_next_event(); cycles != UINT32_MAX) {
+        scheduler.schedule(Scheduler::EVENT_VIA, device_cycle + cycles);
+    }
+    else {
+        scheduler.cancel(Scheduler::EVENT_VIA);
+    }
+
+    if (uint32_t cycles = tape->cycles_to_next_edge(); cycles != UINT32_MAX) {
+        scheduler.schedule(Scheduler::EVENT_TAPE, device_cycle + cycles);
+    }
+    else {
+        scheduler.cancel(Scheduler::EVENT_TAPE);
     }
 }
 
@@ -212,6 +516,9 @@ void Machine::key_press(uint8_t key_bits, bool down)
     else {
         key_rows[key_bits >> 3] &= ~(1 << (key_bits & 0x07));
     }
+
+    // Sense line is otherwise only refreshed on VIA reads.
+    update_key_output();
 }
 
 void Machine::update_key_output()
@@ -241,6 +548,32 @@ void Machine::via_orb_changed(uint8_t orb)
     }
 }
 
+bool Machine::start_trace(const std::string& path)
+{
+    if (! trace.start(path)) {
+        return false;
+    }
+    cpu->trace = &trace;
+    return true;
+}
+
+void Machine::stop_trace()
+{
+    cpu->trace = nullptr;
+    trace.stop();
+}
+
+void Machine::start_profile()
+{
+    profiler.reset();
+    cpu->profiler = &profiler;
+}
+
+void Machine::stop_profile()
+{
+    cpu->profiler = nullptr;
+}
+
 void Machine::save_snapshot()
 {
     cpu->save_to_snapshot(snapshot);
@@ -257,6 +590,9 @@ void Machine::load_snapshot()
     mos_6522->load_from_snapshot(snapshot);
     memory.load_from_snapshot(snapshot);
     ay3->load_from_snapshot(snapshot);
+    schedule_devices();
+    forget_idle_loop();
+    ula.invalidate();
 
     std::cout << "Loaded snapshot." << std::endl;
 }
@@ -25,8 +25,12 @@
 #include "chip/mos6522.hpp"
 #include "chip/ay3_8912.hpp"
 #include "chip/ula.hpp"
+#include "hle.hpp"
 #include "memory.hpp"
+#include "scheduler.hpp"
+#include "profiler.hpp"
 #include "snapshot.hpp"
+#include "trace.hpp"
 
 #include "tape/tape_tap.hpp"
 #include "tape/tape_blank.hpp"
@@ -34,6 +38,28 @@
 class Oric;
 class Frontend;
 class AY3_8912;
+class Machine;
+
+
+/**
+ * CPU bus of the Oric. RAM and ROM are accessed through the memory page tables,
+ * anything else is I/O or watched pages handled by Machine.
+ */
+class OricBus
+{
+public:
+    OricBus(Machine& machine);
+
+    inline uint8_t read_byte(uint16_t address);
+    inline uint8_t read_byte_zp(uint8_t address);
+    inline uint16_t read_word(uint16_t address);
+    inline uint16_t read_word_zp(uint8_t address);
+    inline void write_byte(uint16_t address, uint8_t val);
+    inline void write_byte_zp(uint8_t address, uint8_t val);
+
+    Machine& machine;
+    Memory& memory;
+};
 
 
 class Machine
@@ -44,7 +70,7 @@ public:
 
     /**
      * Init the machine.
-     * @param frontend pointer to Frontend object
+     * @param frontend pointer to Frontend object, or nullptr to run without graphics and sound
      */
     void init(Frontend* frontend);
 
@@ -86,6 +112,164 @@ public:
      */
     void run(uint16_t address, Oric* oric) { cpu->set_pc(address); run(oric); }
 
+    /**
+     * Run for a number of cycles as fast as possible, without frame pacing or frontend events.
+     * Stops at the first raster line end after the cycles have passed.
+     * @param cycles number of cycles to run
+     * @param oric Pointer to Oric object
+     * @return false if execution was stopped by break
+     */
+    bool run_for(uint64_t cycles, Oric* oric);
+
+    /**
+     * Run until next scheduled event, in the mode given by cycle_exact. Breakpoints
+     * are only checked when there are any, trace and profile only recorded when running.
+     * @param oric Pointer to Oric object
+     * @return false if execution was stopped by break
+     */
+    bool run_to_event(Oric* oric);
+
+    /**
+     * Run until next scheduled event one clock cycle at a time, stepping all chips every cycle.
+     * @tparam Debug true to check breakpoints and watchpoints
+     * @param oric Pointer to Oric object
+     * @return false if execution was stopped by break
+     */
+    template <bool Debug>
+    bool run_cycles(Oric* oric);
+
+    /**
+     * Run CPU until next scheduled event one instruction at a time. Other chips
+     * catch up on events and when the CPU accesses the VIA.
+     * @tparam Debug true to check breakpoints and watchpoints
+     * @param oric Pointer to Oric object
+     * @return false if execution was stopped by break
+     */
+    template <bool Debug>
+    bool run_instructions(Oric* oric);
+
+    /**
+     * Run CPU until next scheduled event one instruction at a time, recording
+     * registers while looking for an idle loop. An idle loop is a sequence of
+     * instructions without side effects that passes through the same registers
+     * twice in a row, so it will repeat until an interrupt is taken.
+     * @param oric Pointer to Oric object
+     * @return false if execution was stopped by break
+     */
+    bool probe_idle_loop(Oric* oric);
+
+    /**
+     * If the CPU is in the detected idle loop, advance it to the next scheduled
+     * event without executing the loop. Otherwise forget the loop.
+     * @return true if idle loop was skipped
+     */
+    bool skip_idle_loop();
+
+    /**
+     * Forget detected idle loop and any running probe, since memory may have changed.
+     */
+    void forget_idle_loop();
+
+    /**
+     * Handle all scheduled events that are due.
+     * @return true if a full frame was rendered
+     */
+    bool handle_events();
+
+    /**
+     * Read from an I/O page or a page with watchpoints.
+     * @param address address to read
+     * @return read value
+     */
+    uint8_t read_io(uint16_t address);
+
+    /**
+     * Write to an I/O page or a page with watchpoints.
+     * @param address address to write
+     * @param val value to write
+     */
+    void write_io(uint16_t address, uint8_t val);
+
+    /**
+     * Note CPU write to video memory, for the ULA to paint changed raster lines.
+     * @param address written address
+     */
+    void video_written(uint16_t address) { ula.mark_written(address); }
+
+    /**
+     * Let VIA, AY and tape catch up with given cycle.
+     * @param cycle scheduler cycle to catch up with
+     */
+    void sync_devices(uint64_t cycle);
+
+    /**
+     * Let VIA, AY and tape catch up with the cycle of the current CPU bus access.
+     * An instruction run whole does its accesses on its last cycle, but the scheduler
+     * cycle is only advanced after it. In cycle exact mode devices are already stepped
+     * to the current cycle, and get_cycles_ahead() is zero.
+     */
+    void sync_devices_to_access() { sync_devices(scheduler.cycle + cpu->get_cycles_ahead()); }
+
+    /**
+     * Schedule next VIA and tape events, based on their current state.
+     */
+    void schedule_devices();
+
+    /**
+     * Get number of cycles run since start.
+     * @return cycle count
+     */
+    uint64_t get_cycle() { return scheduler.cycle; }
+
+    /**
+     * Start tracing executed instructions to file.
+     * @param path path of trace file
+     * @return false if trace file could not be created
+     */
+    bool start_trace(const std::string& path);
+
+    /**
+     * Stop tracing executed instructions.
+     */
+    void stop_trace();
+
+    /**
+     * Start recording execution profile, clearing any previous profile.
+     */
+    void start_profile();
+
+    /**
+     * Stop recording execution profile, keeping the profile.
+     */
+    void stop_profile();
+
+    /**
+     * Get execution profile.
+     * @return reference to profiler
+     */
+    Profiler& get_profiler() { return profiler; }
+
+    /**
+     * Run known routines of the ROM at $c000 natively instead of on the CPU, see Hle.
+     * Not available in cycle exact mode.
+     * @return false if ROM is unknown or emulation is cycle exact
+     */
+    bool enable_hle();
+
+    /**
+     * Run known routines of a ROM natively, without checking that it is the ROM at $c000.
+     * @param rom_crc CRC-32 of the ROM
+     * @return false if ROM is unknown or emulation is cycle exact
+     */
+    bool enable_hle(uint32_t rom_crc);
+
+    /**
+     * Run routine trapped by the CPU natively.
+     * @param address trapped address
+     * @return false if routine should run on the CPU
+     */
+    bool run_trap(uint16_t address);
+
     /**
      * Stop the machine.
      */
@@ -135,51 +319,7 @@ public:
      */
     bool toggle_warp_mode();
 
-    // --- Memory functions -------------------
-
-    static uint8_t read_byte(Machine& machine, uint16_t address)
-    {
-        if (address >= 0x300 && address < 0x400) {
-            return machine.mos_6522->read_byte(address);
-        }
-        return machine.memory.mem[address];
-    }
-
-    static uint8_t read_byte_zp(Machine &machine, uint8_t address)
-    {
-        return machine.memory.mem[address];
-    }
-
-    static uint16_t read_word(Machine &machine, uint16_t address)
-    {
-        return machine.memory.mem[address] | machine.memory.mem[address + 1] << 8;
-    }
-
-    static uint16_t read_word_zp(Machine &machine, uint8_t address)
-    {
-        return machine.memory.mem[address] | machine.memory.mem[address + 1 & 0xff] << 8;
-    }
-
-    static void write_byte(Machine &machine, uint16_t address, uint8_t val)
-    {
-        if (address >= 0xc000) {
-            return;
-        }
-
-        if (address >= 0x300 && address < 0x400) {
-            machine.mos_6522->write_byte(address, val);
-        }
-
-        machine.memory.mem[address] = val;
-    }
-
-    static void write_byte_zp(Machine &machine, uint8_t address, uint8_t val)
-    {
-        if (address > 0x00ff) {
-            return;
-        }
-        machine.memory.mem[address] = val;
-    }
+    // --- Callbacks -------------------
 
     static uint8_t read_via_ora(Machine& machine)
     {
@@ -206,22 +346,47 @@ public:
         machine.irq_clear();
     }
 
-    MOS6502* cpu;
+    static bool trap_callback(OricBus& bus, uint16_t address)
+    {
+        return bus.machine.run_trap(address);
+    }
+
+    MOS6502<OricBus>* cpu;
     MOS6522* mos_6522;
     AY3_8912* ay3;
     bool break_exec;
     Memory memory;
     Frontend* frontend;
     bool warpmode_on;
+    bool cycle_exact;
 
 protected:
     ULA ula;
     Oric* oric;
     Tape* tape;
 
-    int32_t cycle_count;
+    Scheduler scheduler;
+    Trace trace;
+    Profiler profiler;
+    Hle hle;
+    bool hle_enabled;
+    uint64_t device_cycle;
     uint64_t next_frame;
 
+    // Idle loop detection, see probe_idle_loop(). A detected loop is kept in
+    // the first idle_period entries of idle_states and idle_cycles.
+    static constexpr uint32_t idle_probe_length = 48;
+    static constexpr uint32_t idle_max_period = 16;
+    static constexpr uint32_t idle_probe_interval = 4;
+
+    MOS6502<OricBus>::Registers idle_states[idle_probe_length];
+    uint8_t idle_cycles[idle_probe_length];
+    uint32_t idle_count;            // Instructions recorded by running probe.
+    uint32_t idle_period;           // Instructions in detected loop, 0 if none.
+    uint32_t idle_loop_cycles;      // Cycles of one iteration of detected loop.
+    uint32_t idle_probe_countdown;  // Event windows until next probe.
+    bool idle_probing;
+
     bool sound_paused;
     uint32_t sound_pause_counter;
 
@@ -231,4 +396,58 @@ protected:
     Snapshot snapshot;
 };
 
+
+inline OricBus::OricBus(Machine& machine) :
+    machine(machine),
+    memory(machine.memory)
+{}
+
+inline uint8_t OricBus::read_byte(uint16_t address)
+{
+    if (const uint8_t* page = memory.read_pages[address >> 8]) {
+        return page[address & 0xff];
+    }
+    return machine.read_io(address);
+}
+
+inline uint8_t OricBus::read_byte_zp(uint8_t address)
+{
+    // Through page table too, so zero page can be watched.
+    if (const uint8_t* page = memory.read_pages[0]) {
+        return page[address];
+    }
+    return machine.read_io(address);
+}
+
+inline uint16_t OricBus::read_word(uint16_t address)
+{
+    return read_byte(address) | read_byte(address + 1) << 8;
+}
+
+inline uint16_t OricBus::read_word_zp(uint8_t address)
+{
+    return read_byte_zp(address) | read_byte_zp(address + 1) << 8;
+}
+
+inline void OricBus::write_byte(uint16_t address, uint8_t val)
+{
+    if (uint8_t* page = memory.write_pages[address >> 8]) {
+        page[address & 0xff] = val;
+        if ((uint16_t)(address - ULA::video_memory_start) < ULA::video_memory_length) {
+            machine.video_written(address);
+        }
+        return;
+    }
+    machine.write_io(address, val);
+}
+
+inline void OricBus::write_byte_zp(uint8_t address, uint8_t val)
+{
+    if (uint8_t* page = memory.write_pages[0]) {
+        page[address] = val;
+        return;
+    }
+    machine.write_io(address, val);
+}
+
 #endif // MACHINE_H
@@ -31,14 +31,22 @@
 
 
 Memory::Memory(uint32_t size) :
+    memory(size),
     mem(NULL),
     size(size),
-    mempos(0),
-    memory(size)
+    mempos(0)
 {
     mem = memory.data();
 
     std::fill(memory.begin(), memory.end(), 0x00);
+    std::fill(std::begin(page_generation), std::end(page_generation), 0);
+    std::fill(std::begin(read_watched), std::end(read_watched), false);
+    std::fill(std::begin(write_watched), std::end(write_watched), false);
+
+    // Plain RAM for whole address range until mapped otherwise.
+    map_io(0, 0x10000);
+    map_read(0, std::min<uint32_t>(size, 0x10000), mem);
+    map_write(0, std::min<uint32_t>(size, 0x10000), mem);
 }
 
 Memory::~Memory()
@@ -81,6 +89,7 @@ void Memory::load(const std::string& path, uint32_t address)
         }
 
         mem[pos] = *buff;
+        ++page_generation[(pos >> 8) & 0xff];
         pos += result;
         count += result;
     }
@@ -99,6 +108,55 @@ void Memory::save_to_snapshot(Snapshot& snapshot)
 void Memory::load_from_snapshot(Snapshot& snapshot)
 {
     memory = snapshot.memory;
+    for (auto& g : page_generation) { ++g; }
+}
+
+
+void Memory::map_read(uint16_t address, uint32_t length, uint8_t* data)
+{
+    for (uint32_t offset = 0; offset < length; offset += 0x100) {
+        mapped_read_pages[(address + offset) >> 8] = data + offset;
+        update_page((address + offset) >> 8);
+    }
+}
+
+void Memory::map_write(uint16_t address, uint32_t length, uint8_t* data)
+{
+    for (uint32_t offset = 0; offset < length; offset += 0x100) {
+        mapped_write_pages[(address + offset) >> 8] = data + offset;
+        update_page((address + offset) >> 8);
+    }
+}
+
+void Memory::map_write_ignore(uint16_t address, uint32_t length)
+{
+    for (uint32_t offset = 0; offset < length; offset += 0x100) {
+        mapped_write_pages[(address + offset) >> 8] = write_ignore_page;
+        update_page((address + offset) >> 8);
+    }
+}
+
+void Memory::map_io(uint16_t address, uint32_t length)
+{
+    for (uint32_t offset = 0; offset < length; offset += 0x100) {
+        mapped_read_pages[(address + offset) >> 8] = nullptr;
+        mapped_write_pages[(address + offset) >> 8] = nullptr;
+        update_page((address + offset) >> 8);
+    }
+}
+
+void Memory::watch_page(uint8_t page, bool read, bool write)
+{
+    read_watched[page] = read;
+    write_watched[page] = write;
+    update_page(page);
+}
+
+void Memory::update_page(uint8_t page)
+{
+    read_pages[page] = read_watched[page] ? nullptr : mapped_read_pages[page];
+    write_pages[page] = write_watched[page] ? nullptr : mapped_write_pages[page];
+    ++page_generation[page];
 }
 
 
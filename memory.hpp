@@ -82,12 +82,82 @@ public:
      */
     void show(uint32_t pos, uint32_t length);
 
+    /**
+     * Map CPU reads of an address range to given data. Bank switching is done by mapping again.
+     * @param address start address, must be page aligned
+     * @param length number of bytes to map, must be multiple of page size
+     * @param data data to map the range to
+     */
+    void map_read(uint16_t address, uint32_t length, uint8_t* data);
+
+    /**
+     * Map CPU writes of an address range to given data.
+     * @param address start address, must be page aligned
+     * @param length number of bytes to map, must be multiple of page size
+     * @param data data to map the range to
+     */
+    void map_write(uint16_t address, uint32_t length, uint8_t* data);
+
+    /**
+     * Make CPU writes of an address range have no effect, for ROM.
+     * @param address start address, must be page aligned
+     * @param length number of bytes to map, must be multiple of page size
+     */
+    void map_write_ignore(uint16_t address, uint32_t length);
+
+    /**
+     * Map CPU reads and writes of an address range to I/O handlers.
+     * @param address start address, must be page aligned
+     * @param length number of bytes to map, must be multiple of page size
+     */
+    void map_io(uint16_t address, uint32_t length);
+
+    /**
+     * Redirect CPU reads and/or writes of a page to the I/O handlers, for watchpoints.
+     * The page keeps its mapping in mapped_read_pages and mapped_write_pages.
+     * @param page page number
+     * @param read true to redirect reads
+     * @param write true to redirect writes
+     */
+    void watch_page(uint8_t page, bool read, bool write);
+
+    /**
+     * Check if CPU writes can not change what CPU reads from a page, like for ROM.
+     * @param page page number
+     * @return true if page is read only
+     */
+    bool is_read_only(uint8_t page)
+    {
+        return mapped_read_pages[page] && mapped_read_pages[page] != mapped_write_pages[page];
+    }
+
     std::vector<uint8_t> memory;
     uint8_t* mem;
 
+    // Page tables for CPU accesses, one pointer per 256 byte page. Pointers are
+    // offset so that page[address & 0xff] is the byte. nullptr means I/O or watched page.
+    uint8_t* read_pages[256];
+    uint8_t* write_pages[256];
+
+    // Page tables as mapped, without watched pages redirected to I/O.
+    uint8_t* mapped_read_pages[256];
+    uint8_t* mapped_write_pages[256];
+
+    // Incremented when a page is remapped or loaded, for caches of read only page content.
+    uint32_t page_generation[256];
+
 protected:
+    /**
+     * Update CPU page tables of a page from its mapping and watch status.
+     * @param page page number
+     */
+    void update_page(uint8_t page);
+
     uint32_t size;
     uint32_t mempos;
+    uint8_t write_ignore_page[256];
+    bool read_watched[256];
+    bool write_watched[256];
 };
 
 
@@ -22,36 +22,10 @@
 #include <string.h>
 #include <iostream>
 
-#include <map>
-#include <vector>
+#include <string>
 
 #include "memory.hpp"
-
-
-enum class Addressing
-{
-    immediate,
-    absolute,
-    zero_page,
-    implied,
-    indirect_absolute,
-    absolute_indexed_x,
-    absolute_indexed_y,
-    zero_page_indexed_x,
-    zero_page_indexed_y,
-    indexed_indirect_x,
-    indirect_indexed_y,
-    relative,
-    accumulator
-};
-
-
-struct Opcode
-{
-    uint8_t opcode;
-    std::string name;
-    Addressing addressing;
-};
+#include "chip/mos6502_opcode_table.hpp"
 
 
 class Monitor
@@ -74,10 +48,15 @@ public:
      */
     uint16_t disassemble(uint16_t address, size_t bytes);
 
+    /**
+     * Get mnemonic of opcode.
+     * @param opcode opcode
+     * @return mnemonic, or "???" for unknown opcode
+     */
+    std::string opcode_name(uint8_t opcode);
+
 private:
     Memory& memory;
-
-    std::map<uint8_t, Opcode> opcodes;
 };
 
 
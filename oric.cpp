@@ -54,8 +54,6 @@ void Oric::init()
     frontend->init_graphics();
     frontend->init_sound();
 
-    machine->cpu->set_quiet(true);
-
     if (config.use_atmos_rom()) {
         machine->memory.load("ROMS/basic11b.rom", 0xc000);
     }
@@ -63,6 +61,10 @@ void Oric::init()
 //    	machine->memory.load("ROMS/test108k.rom", 0xc000);
         machine->memory.load("ROMS/basic10.rom", 0xc000);
     }
+
+    if (config.hle()) {
+        machine->enable_hle();
+    }
 }
 
 void Oric::init_machine()
@@ -147,6 +149,40 @@ uint16_t Oric::string_to_word(std::string& addr)
 }
 
 
+bool Oric::parse_condition(std::string& source, std::string& compare, std::string& value,
+                           Breakpoints::Condition& condition)
+{
+    static const std::map<std::string, Breakpoints::Source> sources = {
+        {"a", Breakpoints::SOURCE_A}, {"x", Breakpoints::SOURCE_X},
+        {"y", Breakpoints::SOURCE_Y}, {"p", Breakpoints::SOURCE_P}
+    };
+    static const std::map<std::string, Breakpoints::Compare> compares = {
+        {"==", Breakpoints::COMPARE_EQ}, {"!=", Breakpoints::COMPARE_NE},
+        {"<", Breakpoints::COMPARE_LT}, {">", Breakpoints::COMPARE_GT}
+    };
+
+    if (source.length() > 1 && source[0] == '@') {
+        std::string address = source.substr(1);
+        condition.source = Breakpoints::SOURCE_MEMORY;
+        condition.address = string_to_word(address);
+    }
+    else if (auto it = sources.find(source); it != sources.end()) {
+        condition.source = it->second;
+    }
+    else {
+        return false;
+    }
+
+    auto it = compares.find(compare);
+    if (it == compares.end()) {
+        return false;
+    }
+    condition.compare = it->second;
+    condition.value = string_to_word(value);
+    return true;
+}
+
+
 Oric::State Oric::handle_command(std::string& command_line)
 {
     if (command_line.length() == 0) {
@@ -166,34 +202,72 @@ Oric::State Oric::handle_command(std::string& command_line)
     if (cmd == "h") {
         std::cout << "Available monitor commands:" << std::endl << std::endl;
         std::cout << "ay              : print AY-3-8912 sound chip info" << std::endl;
+        std::cout << "bc [address]    : clear breakpoint at address, or all breakpoints" << std::endl;
+        std::cout << "bl              : list breakpoints and watchpoints" << std::endl;
         std::cout << "bs <address>    : set breakpoint for address" << std::endl;
+        std::cout << "bs <address> <a|x|y|p|@address> <==|!=|<|>> <value>" << std::endl;
+        std::cout << "                : set breakpoint with condition on register or memory" << std::endl;
         std::cout << "d               : disassemble from PC" << std::endl;
         std::cout << "d <address> <n> : disassemble from address and n bytes ahead" << std::endl;
-        std::cout << "debug           : show debug output at run time" << std::endl;
         std::cout << "g               : go (continue)" << std::endl;
         std::cout << "g <address>     : go to address and run" << std::endl;
         std::cout << "h               : help (showing this text)" << std::endl;
         std::cout << "i               : print machine info" << std::endl;
         std::cout << "m <address> <n> : dump memory from address and n bytes ahead" << std::endl;
         std::cout << "pc <address>    : set program counter to address" << std::endl;
-        std::cout << "quiet           : prevent debug output at run time" << std::endl;
+        std::cout << "prof on         : start execution profile, clearing previous profile" << std::endl;
+        std::cout << "prof off        : stop execution profile" << std::endl;
+        std::cout << "prof [n]        : show n addresses using most cycles (default 20)" << std::endl;
+        std::cout << "prof csv <file> : save profile per address and opcode to CSV file" << std::endl;
         std::cout << "q               : quit" << std::endl;
         std::cout << "s [n]           : step one or possible n steps" << std::endl;
         std::cout << "sr, softreset   : soft reset oric" << std::endl;
+        std::cout << "trace <file>    : trace executed instructions to file" << std::endl;
+        std::cout << "trace           : stop trace" << std::endl;
         std::cout << "v               : print VIA (6522) info" << std::endl;
+        std::cout << "w <address> [r|w|rw] : watch reads and/or writes of address (default rw)" << std::endl;
+        std::cout << "wc [address]    : clear watchpoint at address, or all watchpoints" << std::endl;
         std::cout << "" << std::endl;
         return STATE_MON;
     }
     else if (cmd == "ay") { // info
         machine->ay3->print_status();
     }
-    else if (cmd == "bs") { // set breakpoint <address>
+    else if (cmd == "bc") { // clear breakpoint [address]
+        Breakpoints& breakpoints = machine->cpu->breakpoints;
         if (parts.size() < 2) {
-            std::cout << "Error: missing address" << std::endl;
+            for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+                breakpoints.clear(addr);
+            }
+            std::cout << "Cleared all breakpoints" << std::endl;
+        }
+        else if (! breakpoints.clear(string_to_word(parts[1]))) {
+            std::cout << "Error: no breakpoint at $" << parts[1] << std::endl;
+        }
+    }
+    else if (cmd == "bl") { // list breakpoints
+        machine->cpu->breakpoints.print();
+    }
+    else if (cmd == "bs") { // set breakpoint <address> [<source> <compare> <value>]
+        if (parts.size() != 2 && parts.size() != 5) {
+            std::cout << "Use: bs <address> [<a|x|y|p|@address> <==|!=|<|>> <value>]" << std::endl;
             return STATE_MON;
         }
         uint16_t addr = string_to_word(parts[1]);
-        machine->cpu->set_breakpoint(addr);
+
+        if (parts.size() == 2) {
+            machine->cpu->breakpoints.set(addr);
+            std::cout << "Set breakpoint at $" << std::hex << addr << std::endl;
+            return STATE_MON;
+        }
+
+        Breakpoints::Condition condition{Breakpoints::SOURCE_A, 0, Breakpoints::COMPARE_EQ, 0};
+        if (! parse_condition(parts[2], parts[3], parts[4], condition)) {
+            std::cout << "Error: invalid condition" << std::endl;
+            return STATE_MON;
+        }
+        machine->cpu->breakpoints.set(addr, condition);
+        std::cout << "Set conditional breakpoint at $" << std::hex << addr << std::endl;
     }
     else if (cmd == "d") { // info
         if (parts.size() == 1) {
@@ -207,10 +281,6 @@ Oric::State Oric::handle_command(std::string& command_line)
         }
         last_address = machine->cpu->get_monitor().disassemble(string_to_word(parts[1]), string_to_word(parts[2]));
     }
-    else if (cmd == "debug") {
-        machine->cpu->set_quiet(false);
-        std::cout << "Debug mode enabled" << std::endl;
-    }
     else if (cmd == "g") { // go <address>
         return STATE_RUN;
     }
@@ -234,14 +304,43 @@ Oric::State Oric::handle_command(std::string& command_line)
         machine->cpu->set_pc(addr);
         machine->cpu->PrintStat();
     }
+    else if (cmd == "prof") { // profile [on|off|n|csv <file>]
+        if (parts.size() == 1) {
+            machine->get_profiler().print_top(machine->cpu->get_monitor(), 20);
+        }
+        else if (parts[1] == "on") {
+            machine->start_profile();
+            std::cout << "Profiling started" << std::endl;
+        }
+        else if (parts[1] == "off") {
+            machine->stop_profile();
+            std::cout << "Profiling stopped" << std::endl;
+        }
+        else if (parts[1] == "csv") {
+            if (parts.size() < 3) {
+                std::cout << "Use: prof csv <file>" << std::endl;
+                return STATE_MON;
+            }
+            if (! machine->get_profiler().save_csv(parts[2], machine->cpu->get_monitor())) {
+                std::cout << "Error: could not write " << parts[2] << std::endl;
+            }
+        }
+        else {
+            uint32_t count;
+            try {
+                count = std::stoul(parts[1]);
+            }
+            catch (std::exception&) {
+                std::cout << "Use: prof [on|off|<count>|csv <file>]" << std::endl;
+                return STATE_MON;
+            }
+            machine->get_profiler().print_top(machine->cpu->get_monitor(), count);
+        }
+    }
     else if (cmd == "q") { // quit
         std::cout << "quit" << std::endl;
         return STATE_QUIT;
     }
-    else if (cmd == "quiet") {
-        machine->cpu->set_quiet(true);
-        std::cout << "Quiet mode enabled" << std::endl;
-    }
     else if (cmd == "s") { // step
         if (parts.size() == 2) {
             machine->run(std::stol(parts[1]), this);
@@ -259,9 +358,49 @@ Oric::State Oric::handle_command(std::string& command_line)
         machine->cpu->NMI();
         std::cout << "NMI triggered" << std::endl;
     }
+    else if (cmd == "trace") { // trace [file]
+        if (parts.size() < 2) {
+            if (machine->cpu->trace) {
+                machine->stop_trace();
+                std::cout << "Trace stopped" << std::endl;
+            }
+            else {
+                std::cout << "No trace running" << std::endl;
+            }
+        }
+        else if (machine->start_trace(parts[1])) {
+            std::cout << "Tracing to " << parts[1] << std::endl;
+        }
+    }
     else if (cmd == "v") { // info
         machine->mos_6522->get_state().print();
     }
+    else if (cmd == "w") { // watch <address> [r|w|rw]
+        if (parts.size() < 2) {
+            std::cout << "Use: w <address> [r|w|rw]" << std::endl;
+            return STATE_MON;
+        }
+        std::string mode = parts.size() > 2 ? parts[2] : "rw";
+        if (mode != "r" && mode != "w" && mode != "rw") {
+            std::cout << "Error: watch mode must be r, w or rw" << std::endl;
+            return STATE_MON;
+        }
+        uint16_t addr = string_to_word(parts[1]);
+        machine->cpu->breakpoints.set_watch(addr, mode.contains('r'), mode.contains('w'));
+        std::cout << "Set watchpoint at $" << std::hex << addr << " (" << mode << ")" << std::endl;
+    }
+    else if (cmd == "wc") { // clear watchpoint [address]
+        Breakpoints& breakpoints = machine->cpu->breakpoints;
+        if (parts.size() < 2) {
+            for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+                breakpoints.clear_watch(addr);
+            }
+            std::cout << "Cleared all watchpoints" << std::endl;
+        }
+        else if (! breakpoints.clear_watch(string_to_word(parts[1]))) {
+            std::cout << "Error: no watchpoint at $" << parts[1] << std::endl;
+        }
+    }
 
     return STATE_MON;
 }
@@ -87,6 +87,17 @@ protected:
     State handle_command(std::string& command_line);
     uint16_t string_to_word(std::string& addr);
 
+    /**
+     * Parse breakpoint condition from monitor command parts.
+     * @param source register name or @ followed by memory address
+     * @param compare comparison operator
+     * @param value value to compare with
+     * @param condition condition to fill in
+     * @return false if condition could not be parsed
+     */
+    bool parse_condition(std::string& source, std::string& compare, std::string& value,
+                         Breakpoints::Condition& condition);
+
     Config& config;
     State state;
     Frontend* frontend;
@@ -0,0 +1,95 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+
+#include "profiler.hpp"
+
+
+Profiler::Profiler() :
+    pc_executions(0x10000, 0),
+    pc_cycles(0x10000, 0),
+    opcode_executions(0x100, 0),
+    opcode_cycles(0x100, 0)
+{
+}
+
+void Profiler::reset()
+{
+    std::fill(pc_executions.begin(), pc_executions.end(), 0);
+    std::fill(pc_cycles.begin(), pc_cycles.end(), 0);
+    std::fill(opcode_executions.begin(), opcode_executions.end(), 0);
+    std::fill(opcode_cycles.begin(), opcode_cycles.end(), 0);
+}
+
+void Profiler::print_top(Monitor& monitor, uint32_t n)
+{
+    uint64_t total = std::accumulate(pc_cycles.begin(), pc_cycles.end(), uint64_t(0));
+    if (total == 0) {
+        std::cout << "No profile recorded." << std::endl;
+        return;
+    }
+
+    std::vector<uint16_t> addresses;
+    for (uint32_t address = 0; address < 0x10000; ++address) {
+        if (pc_cycles[address]) {
+            addresses.push_back(address);
+        }
+    }
+
+    n = std::min<uint32_t>(n, addresses.size());
+    std::partial_sort(addresses.begin(), addresses.begin() + n, addresses.end(),
+                      [this](uint16_t a, uint16_t b) { return pc_cycles[a] > pc_cycles[b]; });
+
+    printf("Total cycles: %llu\n\n", (unsigned long long)total);
+    printf("      cycles       %%   executions  instruction\n");
+    for (uint32_t i = 0; i < n; ++i) {
+        uint16_t address = addresses[i];
+        printf("%12llu  %5.2f  %11llu  ", (unsigned long long)pc_cycles[address],
+               100.0 * pc_cycles[address] / total, (unsigned long long)pc_executions[address]);
+        monitor.disassemble(address);
+        std::cout << std::endl;
+    }
+}
+
+bool Profiler::save_csv(const std::string& path, Monitor& monitor)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (! file) {
+        return false;
+    }
+
+    fprintf(file, "type,key,executions,cycles\n");
+    for (uint32_t address = 0; address < 0x10000; ++address) {
+        if (pc_executions[address]) {
+            fprintf(file, "pc,%04x,%llu,%llu\n", address,
+                    (unsigned long long)pc_executions[address], (unsigned long long)pc_cycles[address]);
+        }
+    }
+    for (uint32_t opcode = 0; opcode < 0x100; ++opcode) {
+        if (opcode_executions[opcode]) {
+            fprintf(file, "opcode,%02x %s,%llu,%llu\n", opcode, monitor.opcode_name(opcode).c_str(),
+                    (unsigned long long)opcode_executions[opcode], (unsigned long long)opcode_cycles[opcode]);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,77 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "monitor.hpp"
+
+
+/**
+ * Execution profile, counting executions and cycles per instruction address and per opcode.
+ * Cycles used to enter an interrupt are counted on the first instruction of the handler.
+ */
+class Profiler
+{
+public:
+    Profiler();
+
+    /**
+     * Clear all counts.
+     */
+    void reset();
+
+    /**
+     * Count an executed instruction.
+     * @param pc address of instruction
+     * @param opcode opcode of instruction
+     * @param cycles cycles used by instruction
+     */
+    void record(uint16_t pc, uint8_t opcode, uint8_t cycles)
+    {
+        ++pc_executions[pc];
+        pc_cycles[pc] += cycles;
+        ++opcode_executions[opcode];
+        opcode_cycles[opcode] += cycles;
+    }
+
+    /**
+     * Print the addresses using most cycles, with disassembly.
+     * @param monitor monitor used to disassemble
+     * @param n number of addresses to print
+     */
+    void print_top(Monitor& monitor, uint32_t n);
+
+    /**
+     * Save all non-zero counts to CSV file.
+     * @param path path of CSV file
+     * @param monitor monitor used for opcode names
+     * @return false if file could not be written
+     */
+    bool save_csv(const std::string& path, Monitor& monitor);
+
+    std::vector<uint64_t> pc_executions;
+    std::vector<uint64_t> pc_cycles;
+    std::vector<uint64_t> opcode_executions;
+    std::vector<uint64_t> opcode_cycles;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,69 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include "scheduler.hpp"
+
+
+Scheduler::Scheduler()
+{
+    reset();
+}
+
+void Scheduler::reset()
+{
+    cycle = 0;
+    next_at = never;
+    queue = {};
+    for (auto& g : generation) { g = 0; }
+}
+
+void Scheduler::schedule(Event event, uint64_t at)
+{
+    queue.push({at, event, ++generation[event]});
+    if (at < next_at) {
+        next_at = at;
+    }
+}
+
+void Scheduler::cancel(Event event)
+{
+    ++generation[event];
+}
+
+bool Scheduler::pop_due(Event& event, uint64_t& at)
+{
+    drop_stale();
+    if (queue.empty() || queue.top().at > cycle) {
+        return false;
+    }
+
+    event = queue.top().event;
+    at = queue.top().at;
+    queue.pop();
+    ++generation[event];
+
+    drop_stale();
+    return true;
+}
+
+void Scheduler::drop_stale()
+{
+    while (! queue.empty() && queue.top().generation != generation[queue.top().event]) {
+        queue.pop();
+    }
+    next_at = queue.empty() ? never : queue.top().at;
+}
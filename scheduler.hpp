@@ -0,0 +1,100 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+
+/**
+ * Keeps the global cycle counter and a queue of timed events.
+ * Each event type has at most one pending occurrence, rescheduling replaces the old one.
+ */
+class Scheduler
+{
+public:
+    enum Event
+    {
+        EVENT_RASTER = 0,   // End of raster line, ULA paints line.
+        EVENT_VIA,          // VIA timer expiry or other VIA activity.
+        EVENT_TAPE,         // Tape pulse edge.
+        NUM_EVENTS
+    };
+
+    static constexpr uint64_t never = UINT64_MAX;
+
+    Scheduler();
+
+    /**
+     * Reset cycle counter and remove all events.
+     */
+    void reset();
+
+    /**
+     * Schedule event at given cycle, replacing any pending event of same type.
+     * @param event event type
+     * @param at cycle to trigger event at
+     */
+    void schedule(Event event, uint64_t at);
+
+    /**
+     * Remove pending event of given type.
+     * @param event event type
+     */
+    void cancel(Event event);
+
+    /**
+     * Get cycle of next pending event. May be earlier than the real next event
+     * after a cancel, in which case pop_due() finds nothing and updates it.
+     * @return cycle of next event, or never if no events are pending
+     */
+    uint64_t next_event_cycle() { return next_at; }
+
+    /**
+     * Take next event due at or before current cycle.
+     * @param event set to type of due event
+     * @param at set to cycle event was scheduled at
+     * @return false if no event is due
+     */
+    bool pop_due(Event& event, uint64_t& at);
+
+    uint64_t cycle;
+
+protected:
+    struct Entry
+    {
+        uint64_t at;
+        Event event;
+        uint32_t generation;
+
+        bool operator>(const Entry& other) const { return at > other.at; }
+    };
+
+    /**
+     * Drop events that have been cancelled or rescheduled from top of queue.
+     */
+    void drop_stale();
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    uint32_t generation[NUM_EVENTS];
+    uint64_t next_at;
+};
+
+#endif // SCHEDULER_H
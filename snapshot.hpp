@@ -21,6 +21,7 @@
 #include <memory>
 #include <vector>
 
+#include "chip/mos6502_alu.hpp"
 #include "chip/mos6522.hpp"
 #include "chip/ay3_8912.hpp"
 
@@ -35,13 +36,7 @@ public:
     uint8_t X;
     uint8_t Y;
 
-    uint8_t N_INTERN; // negative
-    uint8_t Z_INTERN; // zero
-    bool V; // overflow
-    bool B; // break
-    bool D; // decimal
-    bool I; // interrupt
-    bool C; // carry
+    LazyFlags flags;
 
     uint16_t PC;
     uint8_t SP;
@@ -54,7 +49,9 @@ public:
     bool instruction_load;
     uint8_t instruction_cycles;
     uint8_t current_instruction;
+    uint16_t current_operand;
     uint8_t current_cycle;
+    uint8_t data_latch;
 };
 
 
@@ -18,6 +18,7 @@
 #ifndef TAPE_H
 #define TAPE_H
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <map>
@@ -56,6 +57,18 @@ public:
      */
     virtual void exec() = 0;
 
+    /**
+     * Execute a number of cycles.
+     * @param cycles number of cycles to execute
+     */
+    virtual void exec(uint32_t cycles) = 0;
+
+    /**
+     * Get number of cycles until next pulse edge.
+     * @return cycles until next edge (1 means next cycle), UINT32_MAX if none
+     */
+    virtual uint32_t cycles_to_next_edge() = 0;
+
     /**
      * Check if motor is running.
      * @return true if motor is running.
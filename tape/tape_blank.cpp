@@ -49,3 +49,11 @@ void TapeBlank::set_motor(bool motor_on)
 void TapeBlank::exec()
 {}
 
+void TapeBlank::exec(uint32_t)
+{}
+
+uint32_t TapeBlank::cycles_to_next_edge()
+{
+    return UINT32_MAX;
+}
+
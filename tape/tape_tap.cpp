@@ -252,6 +252,34 @@ void TapeTap::exec()
     }
 }
 
+void TapeTap::exec(uint32_t cycles)
+{
+    if (!motor_running) {
+        return;
+    }
+
+    while (cycles) {
+        // No pulse edge within the given cycles, just count down.
+        if (tape_cycles_counter > (int32_t)cycles) {
+            tape_cycles_counter -= cycles;
+            delay = delay > (int32_t)cycles ? delay - cycles : 0;
+            return;
+        }
+
+        exec();
+        --cycles;
+    }
+}
+
+uint32_t TapeTap::cycles_to_next_edge()
+{
+    if (!motor_running) {
+        return UINT32_MAX;
+    }
+
+    return tape_cycles_counter > 1 ? tape_cycles_counter : 1;
+}
+
 
 uint8_t TapeTap::get_current_bit()
 {
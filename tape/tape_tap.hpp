@@ -59,6 +59,18 @@ public:
      */
     void exec() override;
 
+    /**
+     * Execute a number of cycles.
+     * @param cycles number of cycles to execute
+     */
+    void exec(uint32_t cycles) override;
+
+    /**
+     * Get number of cycles until next pulse edge.
+     * @return cycles until next edge (1 means next cycle), UINT32_MAX if none
+     */
+    uint32_t cycles_to_next_edge() override;
+
 protected:
     /**
      * Read tape header.
@@ -20,6 +20,7 @@
 
 #include "../config.hpp"
 #include "../oric.hpp"
+#include "../chip/mos6502_bus.hpp"
 
 
 namespace Unittest {
@@ -27,29 +28,65 @@ namespace Unittest {
 using namespace testing;
 
 
+/**
+ * CPU on flat RAM, with the same members as Machine for the tests.
+ */
+template <typename Bus>
+struct TestMachine
+{
+    TestMachine() :
+        memory(65536),
+        cpu(std::make_unique<MOS6502<Bus>>(Bus(memory)))
+    {
+        cpu->Reset();
+        cpu->set_pc(0);
+    }
+
+    Memory memory;
+    std::unique_ptr<MOS6502<Bus>> cpu;
+};
+
+typedef TestMachine<FlatBus> FlatMachine;
+
+
 class MOS6502Test : public ::testing::Test
 {
 protected:
     virtual void SetUp()
     {
-        Config config;
-
-        oric = new Oric(config);
-        oric->init_machine();
-        oric->get_machine().init_cpu();
-        oric->get_machine().reset();
-        oric->get_machine().cpu->set_pc(0);
+        flat_machine = new FlatMachine();
     }
 
     virtual void TearDown()
     {
-        delete oric;
+        delete flat_machine;
     }
 
-    void run(Machine& machine) {
+    // Run cycle by cycle until BRK has been executed.
+    template <typename M>
+    void run(M& machine) {
+        bool brk = false;
+        uint8_t opcode = machine.memory.mem[machine.cpu->get_pc()];
+        while (true) {
+            if (machine.cpu->exec(brk)) {
+                if (opcode == BRK) {
+                    return;
+                }
+                opcode = machine.memory.mem[machine.cpu->get_pc()];
+            }
+        }
+    }
+
+    // Run instruction by instruction with debugging until BRK has been executed or a break is triggered.
+    template <typename M>
+    void run_debug(M& machine) {
         bool brk = false;
         while (! brk) {
-            machine.cpu->exec(brk);
+            uint8_t opcode = machine.memory.mem[machine.cpu->get_pc()];
+            machine.cpu->template exec_instruction<true>(brk);
+            if (opcode == BRK) {
+                return;
+            }
         }
     }
 
@@ -71,14 +108,14 @@ protected:
         return major * 10 + minor;
     }
 
-    Oric* oric;
+    FlatMachine* flat_machine;
 };
 
 // --- LDA ---
 
 TEST_F(MOS6502Test, OpLDA_IMM)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory << LDA_IMM << 0x1f;
     machine.memory << BRK;
     run(machine);
@@ -88,7 +125,7 @@ TEST_F(MOS6502Test, OpLDA_IMM)
 
 TEST_F(MOS6502Test, OpLDA_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x10] = 0x2f;
 
     machine.memory << LDA_ZP << 0x10;
@@ -100,7 +137,7 @@ TEST_F(MOS6502Test, OpLDA_ZP)
 
 TEST_F(MOS6502Test, OpLDA_ZP_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x15] = 0x3f;
     machine.cpu->X = 0x05;
 
@@ -113,7 +150,7 @@ TEST_F(MOS6502Test, OpLDA_ZP_X)
 
 TEST_F(MOS6502Test, OpLDA_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x1234] = 0x4f;
 
     machine.memory << LDA_ABS << 0x34 << 0x12;
@@ -125,7 +162,7 @@ TEST_F(MOS6502Test, OpLDA_ABS)
 
 TEST_F(MOS6502Test, OpLDA_ABS_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x1122] = 0x5f;
     machine.cpu->X = 0x11;
 
@@ -138,7 +175,7 @@ TEST_F(MOS6502Test, OpLDA_ABS_X)
 
 TEST_F(MOS6502Test, OpLDA_ABS_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x2233] = 0x6f;
     machine.cpu->Y = 0x11;
 
@@ -151,7 +188,7 @@ TEST_F(MOS6502Test, OpLDA_ABS_Y)
 
 TEST_F(MOS6502Test, OpLDA_IND_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x4711] = 0x7f;
     machine.memory.mem[0x14] = 0x11;
     machine.memory.mem[0x15] = 0x47;
@@ -167,7 +204,7 @@ TEST_F(MOS6502Test, OpLDA_IND_X)
 
 TEST_F(MOS6502Test, OpLDA_IND_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x4711] = 0x8f;
     machine.memory.mem[0x10] = 0x00;
     machine.memory.mem[0x11] = 0x47;
@@ -186,7 +223,7 @@ TEST_F(MOS6502Test, OpLDA_IND_Y)
 
 TEST_F(MOS6502Test, OpLDX_IMM)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory << LDX_IMM << 0x1f;
     machine.memory << BRK;
     run(machine);
@@ -196,7 +233,7 @@ TEST_F(MOS6502Test, OpLDX_IMM)
 
 TEST_F(MOS6502Test, OpLDX_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x10] = 0x2f;
 
     machine.memory << LDX_ZP << 0x10;
@@ -208,7 +245,7 @@ TEST_F(MOS6502Test, OpLDX_ZP)
 
 TEST_F(MOS6502Test, OpLDX_ZP_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x15] = 0x3f;
     machine.cpu->Y = 0x05;
 
@@ -221,7 +258,7 @@ TEST_F(MOS6502Test, OpLDX_ZP_Y)
 
 TEST_F(MOS6502Test, OpLDX_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x1234] = 0x4f;
 
     machine.memory << LDX_ABS << 0x34 << 0x12;
@@ -233,7 +270,7 @@ TEST_F(MOS6502Test, OpLDX_ABS)
 
 TEST_F(MOS6502Test, OpLDX_ABS_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x1122] = 0x5f;
     machine.cpu->Y = 0x11;
 
@@ -249,7 +286,7 @@ TEST_F(MOS6502Test, OpLDX_ABS_Y)
 
 TEST_F(MOS6502Test, OpLDY_IMM)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory << LDY_IMM << 0x1f;
     machine.memory << BRK;
     run(machine);
@@ -259,7 +296,7 @@ TEST_F(MOS6502Test, OpLDY_IMM)
 
 TEST_F(MOS6502Test, OpLDY_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x10] = 0x2f;
 
     machine.memory << LDY_ZP << 0x10;
@@ -271,7 +308,7 @@ TEST_F(MOS6502Test, OpLDY_ZP)
 
 TEST_F(MOS6502Test, OpLDY_ZP_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x15] = 0x3f;
     machine.cpu->X = 0x05;
 
@@ -284,7 +321,7 @@ TEST_F(MOS6502Test, OpLDY_ZP_X)
 
 TEST_F(MOS6502Test, OpLDY_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x1234] = 0x4f;
 
     machine.memory << LDY_ABS << 0x34 << 0x12;
@@ -296,7 +333,7 @@ TEST_F(MOS6502Test, OpLDY_ABS)
 
 TEST_F(MOS6502Test, OpLDY_ABS_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x1122] = 0x5f;
     machine.cpu->X = 0x11;
 
@@ -313,7 +350,7 @@ TEST_F(MOS6502Test, OpLDY_ABS_X)
 
 TEST_F(MOS6502Test, OpSTA_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->A = 0x1f;
 
     machine.memory << STA_ZP << 0x10;
@@ -325,7 +362,7 @@ TEST_F(MOS6502Test, OpSTA_ZP)
 
 TEST_F(MOS6502Test, OpSTA_ZP_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->A = 0x2f;
     machine.cpu->X = 0x05;
 
@@ -338,7 +375,7 @@ TEST_F(MOS6502Test, OpSTA_ZP_X)
 
 TEST_F(MOS6502Test, OpSTA_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->A = 0x3f;
 
     machine.memory << STA_ABS << 0x34 << 0x12;
@@ -350,7 +387,7 @@ TEST_F(MOS6502Test, OpSTA_ABS)
 
 TEST_F(MOS6502Test, OpSTA_ABS_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->A = 0x4f;
     machine.cpu->X = 0x11;
 
@@ -363,7 +400,7 @@ TEST_F(MOS6502Test, OpSTA_ABS_X)
 
 TEST_F(MOS6502Test, OpSTA_ABS_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->A = 0x5f;
     machine.cpu->Y = 0x11;
 
@@ -376,7 +413,7 @@ TEST_F(MOS6502Test, OpSTA_ABS_Y)
 
 TEST_F(MOS6502Test, OpSTA_IND_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x14] = 0x11;
     machine.memory.mem[0x15] = 0x47;
     machine.cpu->A = 0x6f;
@@ -392,7 +429,7 @@ TEST_F(MOS6502Test, OpSTA_IND_X)
 
 TEST_F(MOS6502Test, OpSTA_IND_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.memory.mem[0x10] = 0x00;
     machine.memory.mem[0x11] = 0x47;
     machine.cpu->A = 0x7f;
@@ -411,7 +448,7 @@ TEST_F(MOS6502Test, OpSTA_IND_Y)
 
 TEST_F(MOS6502Test, OpSTX_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->X = 0x1f;
 
     machine.memory << STX_ZP << 0x10;
@@ -423,7 +460,7 @@ TEST_F(MOS6502Test, OpSTX_ZP)
 
 TEST_F(MOS6502Test, OpSTX_ZP_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->X = 0x2f;
     machine.cpu->Y = 0x05;
 
@@ -436,7 +473,7 @@ TEST_F(MOS6502Test, OpSTX_ZP_Y)
 
 TEST_F(MOS6502Test, OpSTX_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->X = 0x3f;
 
     machine.memory << STX_ABS << 0x34 << 0x12;
@@ -451,7 +488,7 @@ TEST_F(MOS6502Test, OpSTX_ABS)
 
 TEST_F(MOS6502Test, OpSTY_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->Y = 0x1f;
 
     machine.memory << STY_ZP << 0x10;
@@ -463,7 +500,7 @@ TEST_F(MOS6502Test, OpSTY_ZP)
 
 TEST_F(MOS6502Test, OpSTY_ZP_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->Y = 0x2f;
     machine.cpu->X = 0x05;
 
@@ -476,7 +513,7 @@ TEST_F(MOS6502Test, OpSTY_ZP_X)
 
 TEST_F(MOS6502Test, OpSTY_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
     machine.cpu->Y = 0x3f;
 
     machine.memory << STY_ABS << 0x34 << 0x12;
@@ -493,11 +530,11 @@ TEST_F(MOS6502Test, OpSTY_ABS)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_IMM)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i<12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x11;
 
         machine.memory.set_mem_pos(0);
@@ -519,11 +556,11 @@ TEST_F(MOS6502Test, OpADC_IMM_DEC)
     short b[] = {0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11};
     short v[] = {0,    1,    1,    1,    1,    1,    1,    0 };
 
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 8; i++)
     {
-        machine.cpu->D = true;
+        machine.cpu->set_flag(FLAG_D, true);
         machine.cpu->A = a[i];
 
         machine.memory.set_mem_pos(0);
@@ -534,20 +571,20 @@ TEST_F(MOS6502Test, OpADC_IMM_DEC)
 
         run(machine);
         ASSERT_EQ(machine.cpu->A, 0x99);
-        ASSERT_EQ(machine.cpu->V, v[i]);
+        ASSERT_EQ(machine.cpu->get_flag(FLAG_V), v[i]);
     }
 }
 
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_IMM_DEC2)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
 
             machine.memory.set_mem_pos(0);
@@ -565,11 +602,11 @@ TEST_F(MOS6502Test, OpADC_IMM_DEC2)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i<12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x11;
         machine.memory.mem[0x15] = 0x13 * i;
 
@@ -587,13 +624,13 @@ TEST_F(MOS6502Test, OpADC_ZP)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_ZP_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.memory.mem[0x15] = decToBCD(b);
 
@@ -613,11 +650,11 @@ TEST_F(MOS6502Test, OpADC_ZP_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_ZP_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i<12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x11;
         machine.cpu->X = 0x05;
         machine.memory.mem[0x15] = 0x13 * i;
@@ -636,13 +673,13 @@ TEST_F(MOS6502Test, OpADC_ZP_X)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_ZP_X_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->X = 0x05;
             machine.memory.mem[0x15] = decToBCD(b);
@@ -662,11 +699,11 @@ TEST_F(MOS6502Test, OpADC_ZP_X_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.memory.mem[0x1234] = 0x13 * i;
 
@@ -684,13 +721,13 @@ TEST_F(MOS6502Test, OpADC_ABS)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_ABS_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.memory.mem[0x1234] = decToBCD(b);
 
@@ -709,11 +746,11 @@ TEST_F(MOS6502Test, OpADC_ABS_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_ABS_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->X = 0x11;
         machine.memory.mem[0x1245] = 0x13 * i;
@@ -732,13 +769,13 @@ TEST_F(MOS6502Test, OpADC_ABS_X)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_ABS_X_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->X = 0x11;
             machine.memory.mem[0x1245] = decToBCD(b);
@@ -758,11 +795,11 @@ TEST_F(MOS6502Test, OpADC_ABS_X_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_ABS_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->Y = 0x12;
         machine.memory.mem[0x1246] = 0x13 * i;
@@ -781,13 +818,13 @@ TEST_F(MOS6502Test, OpADC_ABS_Y)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_ABS_Y_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->Y = 0x12;
             machine.memory.mem[0x1246] = decToBCD(b);
@@ -807,11 +844,11 @@ TEST_F(MOS6502Test, OpADC_ABS_Y_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_IND_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->X = 0x04;
 
@@ -833,13 +870,13 @@ TEST_F(MOS6502Test, OpADC_IND_X)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_IND_X_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->X = 0x04;
 
@@ -862,11 +899,11 @@ TEST_F(MOS6502Test, OpADC_IND_X_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpADC_IND_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->Y = 0x11;
 
@@ -888,13 +925,13 @@ TEST_F(MOS6502Test, OpADC_IND_Y)
 // Decimal mode
 TEST_F(MOS6502Test, OpADC_IND_Y_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->Y = 0x11;
 
@@ -920,11 +957,11 @@ TEST_F(MOS6502Test, OpADC_IND_Y_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_IMM)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x11;
 
         machine.memory.set_mem_pos(0);
@@ -943,13 +980,13 @@ TEST_F(MOS6502Test, OpSBC_IMM)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_IMM_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
 
             machine.memory.set_mem_pos(0);
@@ -969,11 +1006,11 @@ TEST_F(MOS6502Test, OpSBC_IMM_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_ZP)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x11;
         machine.memory.mem[0x15] = 0x13 * i;
 
@@ -993,13 +1030,13 @@ TEST_F(MOS6502Test, OpSBC_ZP)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_ZP_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.memory.mem[0x15] = decToBCD(b);
 
@@ -1020,11 +1057,11 @@ TEST_F(MOS6502Test, OpSBC_ZP_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_ZP_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x11;
         machine.cpu->X = 0x05;
         machine.memory.mem[0x15] = 0x13 * i;
@@ -1045,13 +1082,13 @@ TEST_F(MOS6502Test, OpSBC_ZP_X)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_ZP_X_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->X = 0x05;
             machine.memory.mem[0x15] = decToBCD(b);
@@ -1073,11 +1110,11 @@ TEST_F(MOS6502Test, OpSBC_ZP_X_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_ABS)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.memory.mem[0x1234] = 0x13 * i;
 
@@ -1097,13 +1134,13 @@ TEST_F(MOS6502Test, OpSBC_ABS)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_ABS_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.memory.mem[0x1234] = decToBCD(b);
 
@@ -1124,11 +1161,11 @@ TEST_F(MOS6502Test, OpSBC_ABS_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_ABS_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->X = 0x11;
         machine.memory.mem[0x1245] = 0x13 * i;
@@ -1149,13 +1186,13 @@ TEST_F(MOS6502Test, OpSBC_ABS_X)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_ABS_X_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->X = 0x11;
             machine.memory.mem[0x1245] = decToBCD(b);
@@ -1177,11 +1214,11 @@ TEST_F(MOS6502Test, OpSBC_ABS_X_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_ABS_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->Y = 0x12;
         machine.memory.mem[0x1246] = 0x13 * i;
@@ -1202,13 +1239,13 @@ TEST_F(MOS6502Test, OpSBC_ABS_Y)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_ABS_Y_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->Y = 0x12;
             machine.memory.mem[0x1246] = decToBCD(b);
@@ -1230,11 +1267,11 @@ TEST_F(MOS6502Test, OpSBC_ABS_Y_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_IND_X)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->X = 0x04;
         machine.memory.mem[0x14] = 0x11;
@@ -1257,13 +1294,13 @@ TEST_F(MOS6502Test, OpSBC_IND_X)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_IND_X_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->X = 0x04;
             machine.memory.mem[0x14] = 0x11;
@@ -1287,11 +1324,11 @@ TEST_F(MOS6502Test, OpSBC_IND_X_DEC)
 // Normal mode
 TEST_F(MOS6502Test, OpSBC_IND_Y)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int i=0; i < 12; i++)
     {
-        machine.cpu->D = false;
+        machine.cpu->set_flag(FLAG_D, false);
         machine.cpu->A = 0x12;
         machine.cpu->Y = 0x11;
         machine.memory.mem[0x10] = 0x00;
@@ -1314,13 +1351,13 @@ TEST_F(MOS6502Test, OpSBC_IND_Y)
 // Decimal mode
 TEST_F(MOS6502Test, OpSBC_IND_Y_DEC)
 {
-    Machine& machine = oric->get_machine();
+    FlatMachine& machine = *flat_machine;
 
     for (int a=0; a <= 99; a++)
     {
         for (int b=0; b <= 99; b++)
         {
-            machine.cpu->D = true;
+            machine.cpu->set_flag(FLAG_D, true);
             machine.cpu->A = decToBCD(a);
             machine.cpu->Y = 0x11;
             machine.memory.mem[0x10] = 0x00;
@@ -1341,4 +1378,495 @@ TEST_F(MOS6502Test, OpSBC_IND_Y_DEC)
     }
 }
 
+// --- Opcode table ---
+
+TEST_F(MOS6502Test, OpcodeTable)
+{
+    // All emulated opcodes have a name and cycles, apart from the trap opcode.
+    for (uint32_t opcode = 0; opcode < 0x100; ++opcode) {
+        const OpcodeInfo& info = opcode_table[opcode];
+        if (info.operation != Operation::unknown && info.operation != Operation::hle_trap) {
+            ASSERT_NE(info.name, nullptr) << opcode;
+            ASSERT_GT(info.cycles, 0) << opcode;
+        }
+        ASSERT_EQ(info.length, addressing_length(info.addressing)) << opcode;
+    }
+
+    ASSERT_EQ(opcode_table[LDA_ABS_X].timing, TIMING_ABS_X);
+    ASSERT_EQ(opcode_table[STA_ABS_X].timing, TIMING_FIXED);
+
+    // Monitor uses the same table.
+    Monitor& monitor = flat_machine->cpu->get_monitor();
+    ASSERT_EQ(monitor.opcode_name(LDA_ZP_X), "LDA");
+    ASSERT_EQ(monitor.opcode_name(LDX_ZP_Y), "LDX");
+    ASSERT_EQ(monitor.opcode_name(ILL_NOP_ABS_X_1C), "(NOP)");
+    ASSERT_EQ(monitor.opcode_name(ILL_ISC_ABS_X), "???");
+}
+
+// --- Status register ---
+
+TEST_F(MOS6502Test, StatusRegister)
+{
+    FlatMachine& machine = *flat_machine;
+
+    // All flags survive conversion to and from lazy form, bit 5 is not stored.
+    for (uint32_t p = 0; p < 0x100; ++p) {
+        machine.cpu->set_p(p);
+        ASSERT_EQ(machine.cpu->get_p(), p & ~0x20) << p;
+    }
+
+    // Flags pushed by PHP after ADC $7f + $01, CMP and LSR.
+    machine.cpu->set_p(0);
+    machine.memory << LDA_IMM << 0x7f << ADC_IMM << 0x01 << PHP;
+    machine.memory << CMP_IMM << 0x80 << PHP;
+    machine.memory << LSR_ACC << PHP;
+    machine.memory << BRK;
+    run(machine);
+    ASSERT_EQ(machine.memory.mem[0x01ff], FLAG_N | FLAG_V);
+    ASSERT_EQ(machine.memory.mem[0x01fe], FLAG_V | FLAG_Z | FLAG_C);
+    ASSERT_EQ(machine.memory.mem[0x01fd], FLAG_V);
+}
+
+// --- ALU tables ---
+
+/**
+ * Result of an ADC or SBC, calculated the way MOS6502 did before its tables.
+ */
+struct ReferenceAlu
+{
+    uint8_t a;
+    bool n;
+    bool v;
+    bool z;
+    bool c;
+
+    static ReferenceAlu adc(bool c, uint8_t a, uint8_t value, bool d)
+    {
+        if (d) {
+            uint16_t low = (a & 0x0f) + (value & 0x0f) + (c ? 1 : 0);
+            if (low > 9) low += 6;
+            uint16_t high = (a >> 4) + (value >> 4) + (low > 0x0f);
+
+            bool z = ((a + value + (c ? 1 : 0)) & 0xff) == 0;
+            bool n = high & 0x08;
+            bool v = ~(a ^ value) & (a ^ (high << 4)) & 0x80;
+
+            if (high > 9) high += 6;
+            return {uint8_t((high << 4) | (low & 0x0f)), n, v, z, high > 0x0f};
+        }
+        uint16_t w = a + value + (c ? 1 : 0);
+        return {uint8_t(w), bool(w & 0x80), bool(~(a ^ value) & (a ^ w) & 0x80), (w & 0xff) == 0, w > 0xff};
+    }
+
+    static ReferenceAlu sbc(bool c, uint8_t a, uint8_t value, bool d)
+    {
+        uint16_t w = a - value - (c ? 0 : 1);
+        ReferenceAlu result{uint8_t(w), bool(w & 0x80), bool((a ^ value) & (a ^ w) & 0x80), (w & 0xff) == 0, w < 0x100};
+        if (d) {
+            uint16_t low = (a & 0x0f) - (value & 0x0f) - (c ? 0 : 1);
+            uint16_t high = (a >> 4) - (value >> 4);
+            if (low & 0x10) {
+                low -= 6;
+                --high;
+            }
+            if (high & 0x10) {
+                high -= 6;
+            }
+            result.a = (high << 4) | (low & 0x0f);
+        }
+        return result;
+    }
+
+    bool operator==(const AluResult& other) const
+    {
+        return a == other.value && n == bool(other.flags & FLAG_N) && v == bool(other.flags & FLAG_V) &&
+               z == bool(other.flags & FLAG_Z) && c == bool(other.flags & FLAG_C);
+    }
+};
+
+TEST_F(MOS6502Test, AluTables)
+{
+    for (uint32_t carry = 0; carry < 2; ++carry) {
+        for (uint32_t a = 0; a < 0x100; ++a) {
+            for (uint32_t value = 0; value < 0x100; ++value) {
+                uint32_t i = alu_index(carry, a, value);
+                ASSERT_TRUE(ReferenceAlu::adc(carry, a, value, true) == adc_decimal_table[i]) << i;
+                ASSERT_TRUE(ReferenceAlu::sbc(carry, a, value, true) == sbc_decimal_table[i]) << i;
+                ASSERT_TRUE(ReferenceAlu::adc(carry, a, value, false) == alu_adc(carry, a, value, false)) << i;
+                ASSERT_TRUE(ReferenceAlu::sbc(carry, a, value, false) == alu_sbc(carry, a, value, false)) << i;
+            }
+        }
+    }
+
+    // Decimal SBC sets carry when there is no borrow, like binary SBC.
+    FlatMachine& machine = *flat_machine;
+    machine.memory << SED;
+    machine.memory << SEC;
+    machine.memory << LDA_IMM;
+    machine.memory << 0x10;
+    machine.memory << SBC_IMM;
+    machine.memory << 0x20;
+    machine.memory << BRK;
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x90);
+    ASSERT_FALSE(machine.cpu->get_flag(FLAG_C));
+}
+
+// --- Instruction stepping ---
+
+TEST_F(MOS6502Test, ExecInstructionCycles)
+{
+    FlatMachine& machine = *flat_machine;
+    machine.cpu->X = 0x01;
+    machine.memory.mem[0x1100] = 0x47;
+
+    machine.memory.set_mem_pos(0);
+    machine.memory << LDA_IMM;
+    machine.memory << 0x01;
+    machine.memory << LDA_ABS_X;    // Crosses page, one extra cycle.
+    machine.memory << 0xff;
+    machine.memory << 0x10;
+    machine.memory << BNE;          // Taken, same page, one extra cycle.
+    machine.memory << 0x00;
+    machine.memory << BRK;
+
+    bool brk = false;
+    ASSERT_EQ(machine.cpu->exec_instruction(brk), 2);
+    ASSERT_EQ(machine.cpu->exec_instruction(brk), 5);
+    ASSERT_EQ(machine.cpu->exec_instruction(brk), 3);
+    ASSERT_EQ(machine.cpu->exec_instruction(brk), 7);
+    ASSERT_FALSE(brk);
+}
+
+TEST_F(MOS6502Test, TracingBusAccesses)
+{
+    TestMachine<TracingBus> machine;
+    machine.memory.mem[0x0010] = 0x00;
+    machine.memory.mem[0x0011] = 0x20;
+    machine.memory.mem[0x2005] = 0x7f;
+
+    machine.memory.set_mem_pos(0);
+    machine.memory << LDY_IMM;
+    machine.memory << 0x05;
+    machine.memory << LDA_IND_Y;
+    machine.memory << 0x10;
+    machine.memory << INC_ABS;
+    machine.memory << 0x00;
+    machine.memory << 0x30;
+
+    bool brk = false;
+    machine.cpu->exec_instruction(brk);
+    std::vector<TracingBus::Access>& accesses = machine.cpu->get_bus().accesses;
+    accesses.clear();
+
+    machine.cpu->exec_instruction(brk);
+    ASSERT_EQ(machine.cpu->A, 0x7f);
+    std::vector<TracingBus::Access> expected = {
+        {0x0002, LDA_IND_Y, false},     // Decode.
+        {0x0003, 0x10, false},
+        {0x0010, 0x00, false},          // Page check for timing.
+        {0x0011, 0x20, false},
+        {0x0010, 0x00, false},          // Execute.
+        {0x0011, 0x20, false},
+        {0x2005, 0x7f, false}
+    };
+    ASSERT_EQ(accesses, expected);
+
+    accesses.clear();
+    machine.cpu->exec_instruction(brk);
+    ASSERT_EQ(machine.memory.mem[0x3000], 0x01);
+    ASSERT_EQ(accesses.back(), (TracingBus::Access{0x3000, 0x01, true}));
+}
+
+// --- Bus timing ---
+
+TEST_F(MOS6502Test, BusTiming)
+{
+    TestMachine<TracingBus> machine;
+    machine.cpu->X = 0x01;
+    machine.memory.mem[0x3000] = 0x11;
+    machine.memory.mem[0x3100] = 0x47;
+
+    machine.memory.set_mem_pos(0);
+    machine.memory << INC_ABS_X;        // Crosses page.
+    machine.memory << 0xff;
+    machine.memory << 0x30;
+    machine.memory << STA_ABS_X;        // Same page.
+    machine.memory << 0x00;
+    machine.memory << 0x30;
+
+    // Run one instruction a cycle at a time, returning accesses after decode by cycle.
+    auto run_cycles = [&machine](uint8_t cycles) {
+        std::vector<std::vector<TracingBus::Access>> by_cycle;
+        std::vector<TracingBus::Access>& accesses = machine.cpu->get_bus().accesses;
+        bool brk = false;
+        for (uint8_t cycle = 1; cycle <= cycles; ++cycle) {
+            accesses.clear();
+            bool done = machine.cpu->template exec<false, true>(brk);
+            EXPECT_EQ(done, cycle == cycles);
+            by_cycle.push_back(cycle == 1 ? std::vector<TracingBus::Access>{} : accesses);
+        }
+        return by_cycle;
+    };
+
+    std::vector<std::vector<TracingBus::Access>> expected = {
+        {},
+        {},
+        {},
+        {{0x3000, 0x11, false}},        // Before carry to high byte.
+        {{0x3100, 0x47, false}},
+        {{0x3100, 0x47, true}},         // Unmodified value written back.
+        {{0x3100, 0x48, true}}
+    };
+    ASSERT_EQ(run_cycles(7), expected);
+
+    machine.cpu->A = 0x99;
+    expected = {
+        {},
+        {},
+        {},
+        {{0x3001, 0x00, false}},        // Read also without page crossing.
+        {{0x3001, 0x99, true}}
+    };
+    ASSERT_EQ(run_cycles(5), expected);
+}
+
+// --- Memory map ---
+
+TEST_F(MOS6502Test, RomOverlaySwitch)
+{
+    Config config;
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init_cpu();
+    machine.reset();
+    machine.cpu->set_pc(0);
+
+    std::vector<uint8_t> overlay(0x2000, 0x00);
+    overlay[0x0000] = 0x47;
+    machine.memory.mem[0xe000] = 0x11;
+
+    machine.memory.set_mem_pos(0);
+    machine.memory << LDA_ABS;
+    machine.memory << 0x00;
+    machine.memory << 0xe0;
+    machine.memory << BRK;
+
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x11);
+
+    // Switch in overlay ROM.
+    machine.memory.map_read(0xe000, overlay.size(), overlay.data());
+    machine.cpu->set_pc(0);
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x47);
+
+    // Switch back to ROM, writes to ROM are ignored.
+    machine.memory.map_read(0xe000, overlay.size(), &machine.memory.mem[0xe000]);
+    machine.memory.set_mem_pos(0);
+    machine.memory << LDA_IMM;
+    machine.memory << 0x22;
+    machine.memory << STA_ABS;
+    machine.memory << 0x00;
+    machine.memory << 0xe0;
+    machine.memory << LDA_ABS;
+    machine.memory << 0x00;
+    machine.memory << 0xe0;
+    machine.memory << BRK;
+
+    machine.cpu->set_pc(0);
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x11);
+    ASSERT_EQ(overlay[0x0000], 0x47);
+}
+
+TEST_F(MOS6502Test, DecodeCacheRomRemap)
+{
+    Config config;
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init_cpu();
+    machine.reset();
+
+    std::vector<uint8_t> overlay = {LDA_IMM, 0x47, BRK};
+    overlay.resize(0x100);
+
+    // Code in ROM is cached.
+    machine.memory.set_mem_pos(0xc000);
+    machine.memory << LDA_IMM;
+    machine.memory << 0x11;
+    machine.memory << BRK;
+    machine.cpu->set_pc(0xc000);
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x11);
+
+    // Remapping the page drops cached instructions.
+    machine.memory.map_read(0xc000, overlay.size(), overlay.data());
+    machine.cpu->set_pc(0xc000);
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x47);
+
+    // Pages that are both read and written as RAM are never cached.
+    machine.memory.map_read(0xc000, 0x100, &machine.memory.mem[0xc000]);
+    machine.memory.map_write(0xc000, 0x100, &machine.memory.mem[0xc000]);
+    machine.cpu->set_pc(0xc000);
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x11);
+    machine.memory.mem[0xc001] = 0x22;
+    machine.cpu->set_pc(0xc000);
+    run(machine);
+    ASSERT_EQ(machine.cpu->A, 0x22);
+}
+
+// --- Breakpoints ---
+
+TEST_F(MOS6502Test, ConditionalBreakpoint)
+{
+    FlatMachine& machine = *flat_machine;
+    machine.memory << LDX_IMM;
+    machine.memory << 0x00;
+    machine.memory << INX;          // $0002
+    machine.memory << JMP_ABS;
+    machine.memory << 0x02;
+    machine.memory << 0x00;
+
+    machine.cpu->breakpoints.set(0x0002, {Breakpoints::SOURCE_X, 0, Breakpoints::COMPARE_EQ, 0x05});
+
+    run_debug(machine);
+    ASSERT_EQ(machine.cpu->get_pc(), 0x0002);
+    ASSERT_EQ(machine.cpu->X, 0x05);
+
+    // Continuing runs the instruction at the breakpoint.
+    bool brk = false;
+    machine.cpu->exec_instruction<true>(brk);
+    ASSERT_FALSE(brk);
+    ASSERT_EQ(machine.cpu->X, 0x06);
+
+    // Removing the last breakpoint leaves nothing to check.
+    ASSERT_TRUE(machine.cpu->breakpoints.clear(0x0002));
+    ASSERT_TRUE(machine.cpu->breakpoints.empty());
+}
+
+TEST_F(MOS6502Test, Watchpoints)
+{
+    Config config;
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init_cpu();
+    machine.reset();
+    machine.cpu->set_pc(0x0400);
+
+    machine.memory.set_mem_pos(0x0400);
+    machine.memory << LDA_IMM;
+    machine.memory << 0x42;
+    machine.memory << STA_ABS;      // $0402
+    machine.memory << 0x00;
+    machine.memory << 0x20;
+    machine.memory << STA_ZP;       // $0405
+    machine.memory << 0x10;
+    machine.memory << LDX_ZP;       // $0407
+    machine.memory << 0x10;
+    machine.memory << BRK;
+
+    Breakpoints& breakpoints = machine.cpu->breakpoints;
+    breakpoints.set_watch(0x2001, false, true);     // Same page, not hit.
+    breakpoints.set_watch(0x0010, true, false);
+    ASSERT_EQ(machine.memory.write_pages[0x20], nullptr);
+    ASSERT_EQ(machine.memory.read_pages[0x20], &machine.memory.mem[0x2000]);
+
+    run_debug(machine);
+    ASSERT_EQ(machine.cpu->get_pc(), 0x0409);
+    ASSERT_EQ(machine.cpu->X, 0x42);
+    ASSERT_FALSE(breakpoints.watch_write);
+    ASSERT_EQ(breakpoints.watch_address, 0x0010);
+    ASSERT_EQ(machine.memory.mem[0x2000], 0x42);
+
+    ASSERT_TRUE(breakpoints.clear_watch(0x0010));
+    ASSERT_TRUE(breakpoints.clear_watch(0x2001));
+    ASSERT_FALSE(breakpoints.clear_watch(0x2001));
+    ASSERT_TRUE(breakpoints.empty());
+    ASSERT_EQ(machine.memory.read_pages[0x00], &machine.memory.mem[0x0000]);
+    ASSERT_EQ(machine.memory.write_pages[0x20], &machine.memory.mem[0x2000]);
+}
+
+// --- Trace ---
+
+TEST_F(MOS6502Test, TraceToFile)
+{
+    Config config;
+    Oric oric(config);
+    oric.init_machine();
+    Machine& machine = oric.get_machine();
+    machine.init_cpu();
+    machine.reset();
+    machine.cpu->set_pc(0x0400);
+
+    machine.memory.set_mem_pos(0x0400);
+    machine.memory << LDA_IMM;
+    machine.memory << 0x42;
+    machine.memory << STA_ABS;
+    machine.memory << 0x34;
+    machine.memory << 0x12;
+    machine.memory << BRK;
+
+    std::string path = ::testing::TempDir() + "oric_trace_test.bin";
+    ASSERT_TRUE(machine.start_trace(path));
+
+    run_debug(machine);
+    machine.stop_trace();
+
+    FILE* file = fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    char magic[sizeof(trace_magic)];
+    ASSERT_EQ(fread(magic, sizeof(magic), 1, file), 1);
+    ASSERT_EQ(memcmp(magic, trace_magic, sizeof(magic)), 0);
+
+    TraceRecord records[4];
+    ASSERT_EQ(fread(records, sizeof(TraceRecord), 4, file), 3);
+    fclose(file);
+    remove(path.c_str());
+
+    ASSERT_EQ(records[0].pc, 0x0400);
+    ASSERT_EQ(records[0].opcode, LDA_IMM);
+    ASSERT_EQ(records[0].operand_low, 0x42);
+    ASSERT_EQ(records[1].pc, 0x0402);
+    ASSERT_EQ(records[1].opcode, STA_ABS);
+    ASSERT_EQ(records[1].operand_low, 0x34);
+    ASSERT_EQ(records[1].operand_high, 0x12);
+    ASSERT_EQ(records[1].a, 0x42);
+    ASSERT_EQ(records[2].opcode, BRK);
+}
+
+// --- Profiler ---
+
+TEST_F(MOS6502Test, Profile)
+{
+    FlatMachine& machine = *flat_machine;
+    machine.memory << LDX_IMM;
+    machine.memory << 0x03;
+    machine.memory << DEX;          // $0002
+    machine.memory << BNE;
+    machine.memory << 0xfd;
+    machine.memory << BRK;
+
+    Profiler profiler;
+    machine.cpu->profiler = &profiler;
+
+    run_debug(machine);
+
+    ASSERT_EQ(profiler.pc_executions[0x0000], 1);
+    ASSERT_EQ(profiler.pc_executions[0x0002], 3);
+    ASSERT_EQ(profiler.pc_cycles[0x0002], 6);
+    ASSERT_EQ(profiler.pc_executions[0x0003], 3);
+    ASSERT_EQ(profiler.pc_cycles[0x0003], 3 + 3 + 2);     // Taken twice, same page.
+    ASSERT_EQ(profiler.opcode_executions[DEX], 3);
+    ASSERT_EQ(profiler.opcode_cycles[BRK], 7);
+
+    profiler.reset();
+    ASSERT_EQ(profiler.pc_executions[0x0002], 0);
+}
+
 } // Unittest
\ No newline at end of file
@@ -127,6 +127,23 @@ TEST_F(MOS6522TestCounters, T1_interrupt_clear_on_read)
 }
 
 
+TEST_F(MOS6522TestCounters, T1_continuous_pb7_squarewave)
+{
+    mos6522->write_byte(MOS6522::ACR, 0xc0);    // T1 continuous, PB7 output.
+    mos6522->write_byte(MOS6522::T1C_L, 0x03);
+    mos6522->write_byte(MOS6522::T1C_H, 0x00);
+
+    // Period is latch + 2 cycles, first cycle being the initial load.
+    for (int period = 0; period < 4; period++) {
+        for (int i = 0; i < 4; i++) {
+            mos6522->exec();
+        }
+        ASSERT_EQ(mos6522->get_state().orb & 0x80, period & 1 ? 0x80 : 0x00);
+        mos6522->exec();
+        ASSERT_EQ(mos6522->get_state().orb & 0x80, period & 1 ? 0x00 : 0x80);
+    }
+}
+
 // ------ T2 counter ----------
 
 TEST_F(MOS6522TestCounters, T2_tick_down)
@@ -246,4 +263,39 @@ TEST_F(MOS6522TestCounters, T2_pulse_counting)
     ASSERT_EQ(mos6522->read_byte(MOS6522::IFR), MOS6522::IRQ_T2 | 0x80);
 }
 
+TEST_F(MOS6522TestCounters, Multi_cycle_exec_matches_single_cycles)
+{
+    // T1 one shot and continuous, with and without PB7 output. T2 one shot.
+    for (uint8_t acr : {0x00, 0x40, 0x80, 0xc0}) {
+        mos6522->get_state().reset();
+        mos6522->write_byte(MOS6522::ACR, acr);
+        mos6522->write_byte(MOS6522::IER, 0xff);
+
+        mos6522->write_byte(MOS6522::T1C_L, 0x20);
+        mos6522->write_byte(MOS6522::T1C_H, 0x00);
+        mos6522->write_byte(MOS6522::T2C_L, 0x50);
+        mos6522->write_byte(MOS6522::T2C_H, 0x00);
+
+        MOS6522::State start = mos6522->get_state();
+
+        for (uint32_t cycles : {1, 7, 33, 34, 35, 81, 82, 300}) {
+            mos6522->get_state() = start;
+            for (uint32_t i = 0; i < cycles; i++) {
+                mos6522->exec();
+            }
+            uint16_t t1 = mos6522->get_t1_counter();
+            uint16_t t2 = mos6522->get_t2_counter();
+            uint8_t ifr = mos6522->get_state().ifr;
+            uint8_t orb = mos6522->get_state().orb;
+
+            mos6522->get_state() = start;
+            mos6522->exec(cycles);
+            ASSERT_EQ(mos6522->get_t1_counter(), t1) << "acr " << (int)acr << ", " << cycles << " cycles";
+            ASSERT_EQ(mos6522->get_t2_counter(), t2) << "acr " << (int)acr << ", " << cycles << " cycles";
+            ASSERT_EQ(mos6522->get_state().ifr, ifr) << "acr " << (int)acr << ", " << cycles << " cycles";
+            ASSERT_EQ(mos6522->get_state().orb, orb) << "acr " << (int)acr << ", " << cycles << " cycles";
+        }
+    }
+}
+
 } // Unittest
\ No newline at end of file
@@ -0,0 +1,156 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+
+#include <gtest/gtest.h>
+
+#include "../chip/ay3_8912.hpp"
+
+
+namespace Unittest {
+
+using namespace testing;
+
+
+class AY3_8912Test : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        state.reset();
+    }
+
+    void set_register(AY3_8912::SoundState& sound_state, uint8_t reg, uint8_t value)
+    {
+        RegisterChange change{0, reg, value};
+        sound_state.exec_register_change(change);
+    }
+
+    AY3_8912::SoundState state;
+};
+
+
+TEST_F(AY3_8912Test, StepsManyCycles)
+{
+    AY3_8912::SoundState& stepped = state;
+    AY3_8912::SoundState single;
+    single.reset();
+
+    // Changing registers with short and zero periods, all envelope shapes.
+    uint32_t seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    uint32_t cycle = 0;
+    for (uint32_t step = 0; step < 2000; ++step) {
+        if (step % 4 == 0) {
+            uint8_t reg = random() % (AY3_8912::ENV_SHAPE + 1);
+            uint8_t value = random();
+            if (reg != AY3_8912::ENABLE && reg != AY3_8912::CH_A_AMPLITUDE &&
+                reg != AY3_8912::CH_B_AMPLITUDE && reg != AY3_8912::CH_C_AMPLITUDE) {
+                value &= 0x0f;
+            }
+            set_register(stepped, reg, value);
+            set_register(single, reg, value);
+        }
+
+        uint32_t target = cycle + 1 + random() % 600;
+        while (cycle < target) {
+            single.exec_audio(++cycle);
+        }
+        stepped.exec_audio(cycle);
+
+        ASSERT_EQ(stepped.audio_out, single.audio_out);
+        ASSERT_EQ(stepped.noise.rng, single.noise.rng);
+        ASSERT_EQ(stepped.envelope.shape_counter, single.envelope.shape_counter);
+        for (uint8_t channel = 0; channel < 3; ++channel) {
+            ASSERT_EQ(stepped.channels[channel].counter, single.channels[channel].counter);
+            ASSERT_EQ(stepped.channels[channel].value, single.channels[channel].value);
+        }
+    }
+}
+
+TEST_F(AY3_8912Test, BandLimited)
+{
+    state.band_limited = true;
+
+    uint32_t cycle = 0;
+    auto sample = [this, &cycle]() {
+        cycle += 23;
+        state.exec_audio(cycle);
+        return state.audio_out;
+    };
+
+    // Steps settle on the exact level after the kernel.
+    set_register(state, AY3_8912::ENABLE, 0x3f);
+    set_register(state, AY3_8912::CH_A_AMPLITUDE, 0x0f);
+    for (uint32_t i = 0; i < 20; ++i) {
+        sample();
+    }
+    ASSERT_EQ(sample(), 65535 / 4);
+
+    set_register(state, AY3_8912::CH_A_AMPLITUDE, 0x08);
+    for (uint32_t i = 0; i < 20; ++i) {
+        sample();
+    }
+    ASSERT_EQ(sample(), 10344 / 4);
+
+    // Tone above the sample rate is filtered to about half level, without aliasing to full swings.
+    set_register(state, AY3_8912::ENABLE, 0x3e);
+    set_register(state, AY3_8912::CH_A_PERIOD_LOW, 0x01);
+    set_register(state, AY3_8912::CH_A_AMPLITUDE, 0x0f);
+    uint32_t low = 65535;
+    uint32_t high = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t out = sample();
+        if (i >= 20) {
+            low = std::min(low, out);
+            high = std::max(high, out);
+        }
+    }
+    ASSERT_GT(low, 65535 / 4 / 4);
+    ASSERT_LT(high, 65535 / 4 * 3 / 4);
+}
+
+TEST_F(AY3_8912Test, BandLimitedRegisterChangeCycle)
+{
+    AY3_8912::SoundState late;
+    late.reset();
+    AY3_8912::SoundState* states[] = {&state, &late};
+
+    // Amplitude written early and late between the same two samples.
+    uint32_t sums[2] = {0, 0};
+    for (uint8_t i = 0; i < 2; ++i) {
+        AY3_8912::SoundState& sound_state = *states[i];
+        sound_state.band_limited = true;
+        set_register(sound_state, AY3_8912::ENABLE, 0x3f);
+        sound_state.changes.buffer.push_back({i == 0 ? 24u : 45u, AY3_8912::CH_A_AMPLITUDE, 0x0f});
+
+        for (uint32_t cycle = 23; cycle <= 23 * 30; cycle += 23) {
+            sound_state.exec_audio(cycle);
+            sums[i] += sound_state.audio_out;
+        }
+        ASSERT_EQ(sound_state.audio_out, 65535 / 4);
+    }
+
+    // The earlier step reaches the new level sooner.
+    ASSERT_GT(sums[0], sums[1]);
+}
+
+} // Unittest
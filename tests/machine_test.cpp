@@ -0,0 +1,280 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../config.hpp"
+#include "../oric.hpp"
+
+
+namespace Unittest {
+
+using namespace testing;
+
+
+class MachineTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        oric = create_oric().release();
+    }
+
+    virtual void TearDown()
+    {
+        delete oric;
+    }
+
+    /**
+     * Create Oric with a reset machine without frontend.
+     * @return new Oric
+     */
+    std::unique_ptr<Oric> create_oric()
+    {
+        std::unique_ptr<Oric> created = std::make_unique<Oric>(config);
+        created->init_machine();
+        created->get_machine().init(nullptr);
+        created->get_machine().reset();
+        return created;
+    }
+
+    Config config;
+    Oric* oric;
+};
+
+// --- Idle loop ---
+
+TEST_F(MachineTest, IdleLoopSkip)
+{
+    Machine& machine = oric->get_machine();
+    machine.cpu->set_p(FLAG_I);
+
+    // Wait for bit 7 of $0280, then spin in a JMP loop.
+    machine.memory.set_mem_pos(0x0400);
+    machine.memory << LDA_ABS;      // $0400
+    machine.memory << 0x80;
+    machine.memory << 0x02;
+    machine.memory << BPL;
+    machine.memory << 0xfb;
+    machine.memory << JMP_ABS;      // $0405
+    machine.memory << 0x05;
+    machine.memory << 0x04;
+    machine.memory << STA_ABS;      // $0408
+    machine.memory << 0x80;
+    machine.memory << 0x02;
+    machine.memory.mem[0x0280] = 0x00;
+
+    machine.cpu->set_pc(0x0408);
+    ASSERT_FALSE(machine.cpu->is_idle_instruction());
+    machine.cpu->set_pc(0x0400);
+    ASSERT_TRUE(machine.cpu->is_idle_instruction());
+
+    uint64_t start_cycle = machine.get_cycle();
+    uint64_t start_count = machine.cpu->instruction_count;
+    ASSERT_TRUE(machine.run_for(100000, oric));
+
+    // Skipped iterations are counted as if executed: 4 + 3 cycles for two instructions.
+    uint64_t cycles = machine.get_cycle() - start_cycle;
+    uint64_t instructions = machine.cpu->instruction_count - start_count;
+    ASSERT_GE(cycles, 100000);
+    ASSERT_EQ(instructions, cycles / 7 * 2 + (cycles % 7 ? 1 : 0));
+    ASSERT_TRUE(machine.cpu->get_pc() == 0x0400 || machine.cpu->get_pc() == 0x0403);
+    ASSERT_EQ(machine.cpu->A, 0x00);
+    ASSERT_EQ(machine.cpu->get_sp(), 0xff);
+
+    machine.memory.mem[0x0280] = 0x80;
+    ASSERT_TRUE(machine.run_for(1000, oric));
+    ASSERT_EQ(machine.cpu->get_pc(), 0x0405);
+    ASSERT_EQ(machine.cpu->A, 0x80);
+}
+
+// --- Devices ---
+
+TEST_F(MachineTest, ViaAccessCycles)
+{
+    // Start VIA timer 1 and read it after instructions of different lengths.
+    const std::vector<uint8_t> program = {
+        LDA_IMM, 0x30,
+        STA_ABS, 0x04, 0x03,
+        LDA_IMM, 0x00,
+        STA_ABS, 0x05, 0x03,
+        LDA_ABS, 0x04, 0x03,
+        STA_ZP, 0x10,
+        LDX_ABS, 0x04, 0x03,
+        STX_ZP, 0x11,
+        LDY_IMM, 0x05,
+        LDA_ABS_Y, 0xff, 0x02,     // Crosses page.
+        STA_ZP, 0x12,
+        LDX_IMM, 0x00,
+        STA_ABS_X, 0x0f, 0x03,     // Dummy read of VIA before the write.
+        STA_ABS_X, 0x0f, 0x03,
+        STA_ABS_X, 0x0f, 0x03,
+        STA_ABS_X, 0x0f, 0x03,
+        INC_ABS, 0x0f, 0x03,       // Read and dummy write of VIA before the write.
+        LDA_ABS, 0x0d, 0x03,       // Interrupt flags before reading T1 clears them.
+        STA_ZP, 0x13,
+        LDA_ABS, 0x04, 0x03,
+        STA_ZP, 0x14,
+        JMP_ABS, 0x36, 0x04
+    };
+
+    std::unique_ptr<Oric> cycle_exact_oric = create_oric();
+    Machine* machines[] = {&oric->get_machine(), &cycle_exact_oric->get_machine()};
+    machines[1]->cycle_exact = true;
+
+    for (Machine* machine : machines) {
+        std::copy(program.begin(), program.end(), &machine->memory.mem[0x0400]);
+        machine->cpu->set_p(FLAG_I);
+        machine->cpu->set_pc(0x0400);
+        ASSERT_TRUE(machine->run_for(300, machine == machines[0] ? oric : cycle_exact_oric.get()));
+    }
+
+    // Instructions run whole see the VIA as on the last cycle, like in cycle exact mode.
+    for (uint16_t address = 0x10; address <= 0x14; ++address) {
+        ASSERT_EQ(machines[0]->memory.mem[address], machines[1]->memory.mem[address]);
+    }
+}
+
+TEST_F(MachineTest, KeyScan)
+{
+    Machine& machine = oric->get_machine();
+
+    // Select key row 2 and column 5, like the ROM keyboard scan, then keep reading port B.
+    machine.memory.set_mem_pos(0x0400);
+    auto write_via = [&machine](uint8_t reg, uint8_t value) {
+        machine.memory << LDA_IMM << value << STA_ABS << reg << 0x03;
+    };
+    auto write_ay = [&write_via](uint8_t reg, uint8_t value) {
+        write_via(MOS6522::ORA, reg);
+        write_via(MOS6522::PCR, 0xff);     // Latch address.
+        write_via(MOS6522::PCR, 0xdd);
+        write_via(MOS6522::ORA, value);
+        write_via(MOS6522::PCR, 0xfd);     // Write.
+        write_via(MOS6522::PCR, 0xdd);
+    };
+    write_via(MOS6522::DDRA, 0xff);
+    write_via(MOS6522::DDRB, 0xf7);
+    write_ay(AY3_8912::ENABLE, 0x40);
+    write_ay(AY3_8912::IO_PORT_A, 0xff ^ 0x20);
+    write_via(MOS6522::ORB, 0x02);
+    machine.memory << JMP_ABS << 0x80 << 0x04;
+    machine.memory.set_mem_pos(0x0480);
+    machine.memory << LDA_ABS << MOS6522::ORB << 0x03;
+    machine.memory << STA_ZP << 0x10;
+    machine.memory << JMP_ABS << 0x80 << 0x04;
+
+    machine.cpu->set_p(FLAG_I);
+    machine.cpu->set_pc(0x0400);
+    ASSERT_TRUE(machine.run_for(1000, oric));
+    ASSERT_EQ(machine.memory.mem[0x10] & 0x08, 0x00);
+
+    // Sense line follows key presses between reads.
+    machine.key_press(2 * 8 + 5, true);
+    ASSERT_TRUE(machine.run_for(100, oric));
+    ASSERT_EQ(machine.memory.mem[0x10] & 0x08, 0x08);
+
+    machine.key_press(2 * 8 + 4, true);
+    machine.key_press(2 * 8 + 5, false);
+    ASSERT_TRUE(machine.run_for(100, oric));
+    ASSERT_EQ(machine.memory.mem[0x10] & 0x08, 0x00);
+}
+
+// --- High level emulation ---
+
+TEST_F(MachineTest, HleMatchesRom)
+{
+    // BASIC 1.1 block move and clear line routines.
+    const std::vector<uint8_t> block_move = {
+        0xa2, 0x00, 0xa0, 0x00, 0xc4, 0x10, 0xd0, 0x04, 0xe4, 0x11, 0xf0, 0x0f, 0xb1, 0x0c,
+        0x91, 0x0e, 0xc8, 0xd0, 0xf1, 0xe6, 0x0d, 0xe6, 0x0f, 0xe8, 0x4c, 0xc8, 0xed, 0x60
+    };
+    const std::vector<uint8_t> clear_line = {
+        0xa0, 0x27, 0xa9, 0x20, 0x91, 0x12, 0x88, 0x10, 0xfb, 0xa0, 0x00, 0xad, 0x6b, 0x02,
+        0x91, 0x12, 0xad, 0x6c, 0x02, 0xc8, 0x91, 0x12, 0x60
+    };
+
+    struct Case
+    {
+        uint16_t routine;
+        uint16_t source;
+        uint16_t target;
+        uint16_t length;
+    };
+
+    // Screen scroll, overlapping forward copy, empty copy and clear line.
+    const Case cases[] = {
+        {0xedc4, 0xbba8, 0xbb80, 27 * 40},
+        {0xedc4, 0x5010, 0x5013, 0x123},
+        {0xedc4, 0x5000, 0x6000, 0},
+        {0xf71a, 0, 0, 0}
+    };
+
+    for (const Case& c : cases) {
+        // Same routine run by the ROM and natively, on fresh machines.
+        std::unique_ptr<Oric> orics[2] = {create_oric(), create_oric()};
+        Machine* machines[] = {&orics[0]->get_machine(), &orics[1]->get_machine()};
+        uint64_t cycles[2];
+
+        for (uint32_t m = 0; m < 2; ++m) {
+            Machine& machine = *machines[m];
+
+            std::copy(block_move.begin(), block_move.end(), &machine.memory.mem[0xedc4]);
+            std::copy(clear_line.begin(), clear_line.end(), &machine.memory.mem[0xf71a]);
+            for (uint32_t i = 0x4000; i < 0xc000; ++i) {
+                machine.memory.mem[i] = i * 7;
+            }
+            machine.memory.mem[0x0c] = c.source;
+            machine.memory.mem[0x0d] = c.source >> 8;
+            machine.memory.mem[0x0e] = c.target;
+            machine.memory.mem[0x0f] = c.target >> 8;
+            machine.memory.mem[0x10] = c.length;
+            machine.memory.mem[0x11] = c.length >> 8;
+            machine.memory.mem[0x12] = 0xd0;
+            machine.memory.mem[0x13] = 0xbb;
+            machine.memory.mem[0x026b] = 0x07;
+            machine.memory.mem[0x026c] = 0x10;
+
+            machine.memory.set_mem_pos(0x0400);
+            machine.memory << JSR;
+            machine.memory << (c.routine & 0xff);
+            machine.memory << (c.routine >> 8);
+
+            if (m == 1) {
+                ASSERT_TRUE(machine.enable_hle(Hle::basic11b_crc));
+            }
+
+            machine.cpu->set_registers({0x0400, 0x55, 0x66, 0x77, FLAG_N | FLAG_V, 0xff});
+            uint64_t start = machine.get_cycle();
+            uint64_t instruction_cycles = 0;
+            bool brk = false;
+            while (machine.cpu->get_pc() != 0x0403) {
+                instruction_cycles += machine.cpu->exec_instruction(brk);
+                ASSERT_FALSE(brk);
+            }
+            cycles[m] = instruction_cycles + machine.get_cycle() - start;
+        }
+
+        ASSERT_EQ(cycles[0], cycles[1]);
+        ASSERT_TRUE(machines[0]->cpu->get_registers() == machines[1]->cpu->get_registers());
+        ASSERT_EQ(memcmp(machines[0]->memory.mem, machines[1]->memory.mem, 0x10000), 0);
+    }
+}
+
+} // Unittest
@@ -0,0 +1,70 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include <gtest/gtest.h>
+
+#include "../scheduler.hpp"
+
+
+namespace Unittest {
+
+using namespace testing;
+
+
+TEST(SchedulerTest, EventsInOrder)
+{
+    Scheduler scheduler;
+    Scheduler::Event event;
+    uint64_t at;
+
+    scheduler.schedule(Scheduler::EVENT_RASTER, 64);
+    scheduler.schedule(Scheduler::EVENT_VIA, 10);
+    ASSERT_EQ(scheduler.next_event_cycle(), 10);
+
+    scheduler.cycle = 9;
+    ASSERT_FALSE(scheduler.pop_due(event, at));
+
+    scheduler.cycle = 70;
+    ASSERT_TRUE(scheduler.pop_due(event, at));
+    ASSERT_EQ(event, Scheduler::EVENT_VIA);
+    ASSERT_EQ(at, 10);
+    ASSERT_TRUE(scheduler.pop_due(event, at));
+    ASSERT_EQ(event, Scheduler::EVENT_RASTER);
+    ASSERT_EQ(at, 64);
+    ASSERT_FALSE(scheduler.pop_due(event, at));
+    ASSERT_EQ(scheduler.next_event_cycle(), Scheduler::never);
+}
+
+TEST(SchedulerTest, RescheduleAndCancel)
+{
+    Scheduler scheduler;
+    Scheduler::Event event;
+    uint64_t at;
+
+    scheduler.schedule(Scheduler::EVENT_VIA, 10);
+    scheduler.schedule(Scheduler::EVENT_VIA, 30);    // Replaces event at 10.
+    scheduler.schedule(Scheduler::EVENT_TAPE, 20);
+    scheduler.cancel(Scheduler::EVENT_TAPE);
+
+    scheduler.cycle = 100;
+    ASSERT_TRUE(scheduler.pop_due(event, at));
+    ASSERT_EQ(event, Scheduler::EVENT_VIA);
+    ASSERT_EQ(at, 30);
+    ASSERT_FALSE(scheduler.pop_due(event, at));
+}
+
+} // Unittest
@@ -0,0 +1,269 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "../config.hpp"
+#include "../oric.hpp"
+
+
+namespace Unittest {
+
+using namespace testing;
+
+
+class ULATest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        oric = new Oric(config);
+        oric->init_machine();
+        oric->get_machine().init(nullptr);
+        ula = create_ula().release();
+    }
+
+    virtual void TearDown()
+    {
+        delete ula;
+        delete oric;
+    }
+
+    /**
+     * Create ULA painting from the machine memory, apart from the one of the machine.
+     * @return new ULA
+     */
+    std::unique_ptr<ULA> create_ula()
+    {
+        Machine& machine = oric->get_machine();
+        return std::make_unique<ULA>(&machine, &machine.memory, Frontend::texture_width,
+                                     Frontend::texture_height, Frontend::texture_bpp);
+    }
+
+    void paint_frame(ULA& ula)
+    {
+        while (! ula.paint_raster()) {
+        }
+    }
+
+    uint8_t pixel(ULA& ula, uint32_t x, uint32_t y)
+    {
+        return ula.get_pixels()[y * Frontend::texture_width + x];
+    }
+
+    Config config;
+    Oric* oric;
+    ULA* ula;
+};
+
+
+TEST_F(ULATest, PaintsChangedLines)
+{
+    Machine& machine = oric->get_machine();
+
+    std::fill(&machine.memory.mem[0xbb80], &machine.memory.mem[0xc000], 0x00);
+    machine.memory.mem[0xbb80] = 0x11;      // Red paper on first text row.
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 0), 1);
+    ASSERT_EQ(pixel(*ula, 0, 8), 0);
+
+    // Unmarked change is not seen, lines are not painted again.
+    machine.memory.mem[0xbb80] = 0x12;
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 0), 1);
+
+    ula->mark_written(0xbb80);
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 0), 2);
+    ASSERT_EQ(pixel(*ula, 0, 7), 2);
+
+    // Charset change paints lines showing characters.
+    machine.memory.mem[0xbba8] = 'A';
+    ula->mark_written(0xbba8);
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 8), 0);
+    machine.memory.mem[0xb400 + 'A' * 8] = 0x20;
+    ula->mark_written(0xb400 + 'A' * 8);
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 8), 7);
+}
+
+TEST_F(ULATest, LastVisibleLine)
+{
+    Machine& machine = oric->get_machine();
+
+    // Red paper on last text row, lines 216 to 223. No line is captured or painted after it.
+    std::fill(&machine.memory.mem[0xbb80], &machine.memory.mem[0xc000], 0x00);
+    machine.memory.mem[0xbb80 + 27 * 40] = 0x11;
+    ula->invalidate();
+    for (uint32_t raster = 0; raster < 311; ++raster) {
+        ASSERT_FALSE(ula->paint_raster());
+    }
+    ASSERT_TRUE(ula->paint_raster());
+
+    ASSERT_EQ(ula->get_pixels().size(), Frontend::texture_width * ULA::visible_lines);
+    ASSERT_EQ(pixel(*ula, 0, 215), 0);
+    ASSERT_EQ(pixel(*ula, 0, 216), 1);
+    ASSERT_EQ(pixel(*ula, 0, 223), 1);
+}
+
+TEST_F(ULATest, VectorPaint)
+{
+    Machine& machine = oric->get_machine();
+
+    // Text with inverse, blinking, colors and double height, and a hires part.
+    for (uint32_t i = 0x9800; i < 0xc000; ++i) {
+        machine.memory.mem[i] = i * 37 + (i >> 8);
+    }
+    for (uint32_t i = 0xbb80; i < 0xc000; i += 13) {
+        machine.memory.mem[i] = 0x08 + (i & 7);
+    }
+
+    ULA& scalar = *ula;
+    std::unique_ptr<ULA> vector = create_ula();
+    scalar.set_vector_paint(false);
+    vector->set_vector_paint(true);
+
+    // Both blink phases.
+    for (uint32_t frame = 0; frame < 32; ++frame) {
+        paint_frame(scalar);
+        paint_frame(*vector);
+        ASSERT_EQ(scalar.get_pixels(), vector->get_pixels());
+    }
+}
+
+TEST_F(ULATest, ModeChangeMidLine)
+{
+    Machine& machine = oric->get_machine();
+
+    // Text, hires from cell 1 and text again from cell 3.
+    std::fill(&machine.memory.mem[0xa000], &machine.memory.mem[0xc000], 0x40);
+    machine.memory.mem[0xbb80] = 0x1c;
+    machine.memory.mem[0xa001] = 0x7f;
+    machine.memory.mem[0xa002] = 0x18;
+    machine.memory.mem[0xbb83] = 'A';
+    machine.memory.mem[0xb400 + 'A' * 8] = 0x3f;
+    paint_frame(*ula);
+
+    ASSERT_EQ(pixel(*ula, 0, 0), 0);
+    ASSERT_EQ(pixel(*ula, 6, 0), 7);
+    ASSERT_EQ(pixel(*ula, 12, 0), 0);
+    ASSERT_EQ(pixel(*ula, 18, 0), 7);
+    ASSERT_EQ(pixel(*ula, 23, 0), 7);
+    ASSERT_EQ(pixel(*ula, 24, 0), 0);
+}
+
+TEST_F(ULATest, Threaded)
+{
+    Machine& machine = oric->get_machine();
+
+    for (uint32_t i = 0x9800; i < 0xc000; ++i) {
+        machine.memory.mem[i] = i * 37 + (i >> 8);
+    }
+
+    ULA& direct = *ula;
+    std::unique_ptr<ULA> threaded_ula = create_ula();
+    ULA& threaded = *threaded_ula;
+    threaded.set_threaded(true);
+
+    // Change screen and charset between and within frames.
+    for (uint32_t frame = 0; frame < 40; ++frame) {
+        for (uint32_t raster = 0; raster < 312; ++raster) {
+            if (raster % 50 == 0) {
+                uint16_t address = 0x9800 + (frame * 997 + raster * 31) % 0x2800;
+                machine.memory.mem[address] ^= 0x55;
+                direct.mark_written(address);
+                threaded.mark_written(address);
+            }
+            direct.paint_raster();
+            threaded.paint_raster();
+        }
+        threaded.wait_painted();
+        ASSERT_EQ(direct.get_pixels(), threaded.get_pixels());
+    }
+}
+
+TEST_F(ULATest, CharsetWrittenMidFrame)
+{
+    Machine& machine = oric->get_machine();
+
+    std::fill(&machine.memory.mem[0xb400], &machine.memory.mem[0xbb80], 0x00);
+    std::fill(&machine.memory.mem[0xbb80], &machine.memory.mem[0xc000], 'A');
+    ula->invalidate();
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 0), 0);
+
+    // Glyph written after visible line 5 is shown from line 6 in this frame. The
+    // lines before it are painted in this frame too, as their row changed.
+    machine.memory.mem[0xbb81] = 'B';
+    ula->mark_written(0xbb81);
+    for (uint32_t raster = 0; raster < 44 + 6; ++raster) {
+        ula->paint_raster();
+    }
+    std::fill(&machine.memory.mem[0xb400 + 'A' * 8], &machine.memory.mem[0xb400 + 'A' * 8 + 8], 0x3f);
+    ula->mark_written(0xb400 + 'A' * 8, 8);
+    paint_frame(*ula);
+    ASSERT_EQ(pixel(*ula, 0, 5), 0);
+    ASSERT_EQ(pixel(*ula, 0, 6), 7);
+
+    // Lines painted before it are painted again in the next frame.
+    paint_frame(*ula);
+    for (uint32_t y = 0; y < ULA::visible_lines; ++y) {
+        ASSERT_EQ(pixel(*ula, 0, y), 7) << "line " << y;
+    }
+}
+
+TEST_F(ULATest, CharsetWrittenInMergedFrames)
+{
+    Machine& machine = oric->get_machine();
+    auto run_rasters = [this](uint32_t rasters) {
+        for (uint32_t raster = 0; raster < rasters; ++raster) {
+            ula->paint_raster();
+        }
+    };
+    auto write_glyph = [&machine, this](uint8_t pattern) {
+        std::fill(&machine.memory.mem[0xb400 + 'A' * 8], &machine.memory.mem[0xb400 + 'A' * 8 + 8], pattern);
+        ula->mark_written(0xb400 + 'A' * 8, 8);
+    };
+
+    std::fill(&machine.memory.mem[0xb400], &machine.memory.mem[0xbb80], 0x00);
+    std::fill(&machine.memory.mem[0xbb80], &machine.memory.mem[0xc000], 'A');
+    ula->invalidate();
+    paint_frame(*ula);
+
+    // Frames skipped in warp mode are captured on top of each other. The glyph
+    // is written late in the first frame and early in the second.
+    machine.warpmode_on = true;
+    run_rasters(44 + 101);
+    write_glyph(0x3f);
+    run_rasters(312 - (44 + 101));
+    run_rasters(44 + 11);
+    write_glyph(0x0f);
+    paint_frame(*ula);
+    machine.warpmode_on = false;
+
+    paint_frame(*ula);
+    paint_frame(*ula);
+    for (uint32_t y = 0; y < ULA::visible_lines; ++y) {
+        ASSERT_EQ(pixel(*ula, 0, y), 0) << "line " << y;
+        ASSERT_EQ(pixel(*ula, 2, y), 7) << "line " << y;
+    }
+}
+
+} // Unittest
@@ -0,0 +1,68 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// Decode binary trace file written by the monitor trace command into
+// disassembly, one line per instruction with cycle stamp and registers.
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "memory.hpp"
+#include "monitor.hpp"
+#include "trace.hpp"
+
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: trace_decode <trace file>" << std::endl;
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (! file) {
+        std::cerr << "Error: could not open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    char magic[sizeof(trace_magic)];
+    if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, trace_magic, sizeof(magic)) != 0) {
+        std::cerr << "Error: " << argv[1] << " is not a trace file" << std::endl;
+        fclose(file);
+        return 1;
+    }
+
+    // Instruction bytes are placed at their address for the monitor to disassemble.
+    Memory memory(65536);
+    Monitor monitor(memory);
+
+    TraceRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        memory.mem[record.pc] = record.opcode;
+        memory.mem[(uint16_t)(record.pc + 1)] = record.operand_low;
+        memory.mem[(uint16_t)(record.pc + 2)] = record.operand_high;
+
+        printf("%12llu  ", (unsigned long long)record.cycle);
+        monitor.disassemble(record.pc);
+        printf("A: %02X, X: %02X, Y: %02X  |  P: %02X  |  SP: %02X\n",
+               record.a, record.x, record.y, record.p, record.sp);
+    }
+
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,108 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "trace.hpp"
+
+
+Trace::Trace(const uint64_t& cycle, uint32_t capacity) :
+    cycle(cycle),
+    mask(capacity - 1),
+    head(0),
+    tail(0),
+    dropped(0),
+    file(nullptr),
+    writing(false)
+{
+}
+
+Trace::~Trace()
+{
+    stop();
+}
+
+bool Trace::start(const std::string& path)
+{
+    stop();
+
+    file = fopen(path.c_str(), "wb");
+    if (! file) {
+        std::cout << "Error: could not create trace file " << path << std::endl;
+        return false;
+    }
+    fwrite(trace_magic, sizeof(trace_magic), 1, file);
+
+    // Ring is only allocated while tracing.
+    ring.resize(mask + 1);
+    head = 0;
+    tail = 0;
+    dropped = 0;
+
+    writing = true;
+    writer = std::thread(&Trace::write_loop, this);
+    return true;
+}
+
+void Trace::stop()
+{
+    if (! file) {
+        return;
+    }
+
+    writing = false;
+    writer.join();
+
+    fclose(file);
+    file = nullptr;
+
+    std::cout << "Trace stopped after " << std::dec << head << " instructions";
+    if (dropped) {
+        std::cout << ", " << dropped << " dropped";
+    }
+    std::cout << std::endl;
+
+    ring.clear();
+    ring.shrink_to_fit();
+}
+
+void Trace::write_loop()
+{
+    while (true) {
+        // Check before reading head, so the last records are written after stop.
+        bool stopping = ! writing;
+
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+
+        if (h == t) {
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Write up to end of ring, wrapped records are written next turn.
+        uint64_t count = std::min<uint64_t>(h - t, ring.size() - (t & mask));
+        fwrite(&ring[t & mask], sizeof(TraceRecord), count, file);
+        tail.store(t + count, std::memory_order_release);
+    }
+    fflush(file);
+}
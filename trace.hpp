@@ -0,0 +1,134 @@
+// =========================================================================
+//   Copyright (C) 2009-2024 by Anders Piniesjö <pugo@pugo.org>
+//
+//   This program is free software: you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as published by
+//   the Free Software Foundation, either version 3 of the License, or
+//   (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program.  If not, see <http://www.gnu.org/licenses/>
+// =========================================================================
+
+// Binary execution trace. A trace file is the 8 byte magic "ORICTRC1" followed
+// by TraceRecord structs in host byte order, one per executed instruction.
+// tools/trace_decode turns a trace file into disassembly.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr char trace_magic[8] = {'O', 'R', 'I', 'C', 'T', 'R', 'C', '1'};
+
+
+/**
+ * CPU state at the start of an instruction.
+ */
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operand_low;
+    uint8_t operand_high;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t p;
+    uint8_t sp;
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(TraceRecord) == 24, "trace file format depends on record size");
+
+
+/**
+ * Ring buffer of trace records, streamed to file by a writer thread. Records
+ * are added by the emulation thread without locking or waiting. If the writer
+ * falls behind, new records are dropped and counted instead.
+ */
+class Trace
+{
+public:
+    static constexpr uint32_t default_capacity = 1 << 20;
+
+    /**
+     * Create trace.
+     * @param cycle reference to the cycle counter used to stamp records
+     * @param capacity number of records in ring, must be a power of two
+     */
+    Trace(const uint64_t& cycle, uint32_t capacity = default_capacity);
+    ~Trace();
+
+    /**
+     * Start tracing to file, stopping any running trace first.
+     * @param path path of trace file
+     * @return false if file could not be created
+     */
+    bool start(const std::string& path);
+
+    /**
+     * Stop tracing, writing all recorded instructions to file.
+     */
+    void stop();
+
+    /**
+     * Check if trace is running.
+     * @return true if trace is running
+     */
+    bool is_running() { return file != nullptr; }
+
+    /**
+     * Get number of records dropped since start because the ring was full.
+     * @return number of dropped records
+     */
+    uint64_t get_dropped() { return dropped; }
+
+    /**
+     * Add record to ring, stamped with the current cycle.
+     * @param record record to add
+     */
+    void record(TraceRecord record)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask) {
+            ++dropped;
+            return;
+        }
+        record.cycle = cycle;
+        ring[h & mask] = record;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+protected:
+    /**
+     * Write records to file until stopped.
+     */
+    void write_loop();
+
+    const uint64_t& cycle;
+    std::vector<TraceRecord> ring;
+    uint32_t mask;
+
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    uint64_t dropped;
+
+    FILE* file;
+    std::atomic<bool> writing;
+    std::thread writer;
+};
+
+#endif // TRACE_H